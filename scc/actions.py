@@ -38,6 +38,12 @@ class Action(object):
 	Action is what actually does something in SC-Controller. User can assotiate
 	one or more Action to each available button, stick or pad in profile file.
 	"""
+	# Actions are kept in every loaded profile and called for every input
+	# event, so all actions, modifiers and macros are using __slots__.
+	# Subclass that doesn't define __slots__ gets __dict__ back.
+	# 'string' is set only by GUI parser.
+	__slots__ = ( "parameters", "name", "delay_after", "on_action_set",
+		"string" )
 	
 	# Static dict of all available actions, filled later
 	ALL = {}	# used by action parser
@@ -291,6 +297,11 @@ class Action(object):
 		return self.axis(mapper, position, what)
 	
 	
+	def compile_pad(self, c, position, what):
+		""" See scc.compiler """
+		c.call(self, "axis", position, what)
+	
+	
 	def gyro(self, mapper, pitch, yaw, roll, q1, q2, q3, q4):
 		"""
 		Called when action is set by rotating gyroscope.
@@ -300,6 +311,10 @@ class Action(object):
 		pass
 	
 	
+	def compile_gyro(self, c, *a):
+		pass
+	
+	
 	def whole(self, mapper, x, y, what):
 		"""
 		Called when action is executed by moving physical stick or touching
@@ -404,6 +419,8 @@ class RangeOP(object):
 	Allows to specify and store axis range and then use it in modeshift
 	instead of button.
 	"""
+	__slots__ = ( "what", "op", "value", "min", "max", "op_method",
+		"axis_name", "children" )
 	OPS = ("<", ">", "<=", ">=")
 	
 	def __init__(self, what, op, value):
@@ -499,6 +516,10 @@ class RangeOP(object):
 
 class HapticEnabledAction(object):
 	""" Action that can generate haptic feedback """
+	# 'haptic' slot is defined by subclasses; two bases with non-empty
+	# __slots__ can't be combined
+	__slots__ = ()
+	
 	def __init__(self):
 		self.haptic = None
 	
@@ -517,6 +538,8 @@ class HapticEnabledAction(object):
 
 class OSDEnabledAction(object):
 	""" Action that displays some sort of OSD when executed """
+	__slots__ = ()	# 'osd_enabled' slot is defined by subclasses
+	
 	def __init__(self):
 		self.osd_enabled = False
 	
@@ -535,6 +558,7 @@ class SpecialAction(object):
 	Action that needs to call special_actions_handler (aka sccdaemon instance)
 	to actually do something.
 	"""
+	__slots__ = ()
 	SA = ""
 	
 	def execute_named(self, name, mapper, *a):
@@ -560,6 +584,7 @@ class AxisAction(Action):
 	Action used to controll one output axis, such as one trigger
 	or one axis of stick.
 	"""
+	__slots__ = ( "id", "speed", "min", "max" )
 	COMMAND = "axis"
 	
 	AXIS_NAMES = {
@@ -694,6 +719,28 @@ class AxisAction(Action):
 		mapper.syn_list.add(mapper.gamepad)
 	
 	
+	def compile_axis(self, c, position, what):
+		self._compile(c, position, STICK_PAD_MIN, STICK_PAD_MAX)
+	
+	
+	def _compile(self, c, position, in_min, in_max):
+		""" Emits same math as axis and trigger do, with constants inlined """
+		if self.id in (Axes.ABS_Z, Axes.ABS_RZ):
+			lo, hi = TRIGGER_MIN, TRIGGER_MAX
+		elif self.id in (Axes.ABS_HAT0X, Axes.ABS_HAT0Y):
+			lo, hi = -1, 1
+		else:
+			lo, hi = STICK_PAD_MIN, STICK_PAD_MAX
+		p, id = c.tmp(), c.const(self.id)
+		c.emit("%s = float(%s * %r - %r) / %r" % (p, position, self.speed,
+			in_min, in_max - in_min))
+		c.emit("%s = int(max(%r, min(%r, int((%s * %r) + %r))))" % (p, lo, hi,
+			p, self.max - self.min, self.min))
+		c.emit("%s[%s] = %s" % (c.const(AxisAction.old_positions), id, p))
+		c.emit("mapper.gamepad.axisEvent(%s, %s)" % (id, p))
+		c.emit("mapper.syn_list.add(mapper.gamepad)")
+	
+	
 	def change(self, mapper, dx, dy, what):
 		""" Called from CircularModifier """
 		p = AxisAction.old_positions[self.id]
@@ -714,10 +761,15 @@ class AxisAction(Action):
 		AxisAction.old_positions[self.id] = p
 		mapper.gamepad.axisEvent(self.id, p)
 		mapper.syn_list.add(mapper.gamepad)
+	
+	
+	def compile_trigger(self, c, position, old_position):
+		self._compile(c, position, TRIGGER_MIN, TRIGGER_MAX)
 
 
 class RAxisAction(AxisAction):
 	""" Reversed AxisAction (outputs reversed values) """
+	__slots__ = ()
 	COMMAND = "raxis"
 	
 	def __init__(self, id, min = None, max = None):
@@ -739,6 +791,7 @@ class HatAction(AxisAction):
 	Works as AxisAction, but has values preset to emulate emulate movement in
 	either only positive or only negative half of range.
 	"""
+	__slots__ = ()
 	COMMAND = None
 	def describe(self, context):
 		if self.name: return self.name
@@ -754,21 +807,25 @@ class HatAction(AxisAction):
 
 
 class HatUpAction(HatAction):
+	__slots__ = ()
 	COMMAND = "hatup"
 	def __init__(self, id, *a):
 		HatAction.__init__(self, id, 0, STICK_PAD_MIN + 1)
 
 class HatDownAction(HatAction):
+	__slots__ = ()
 	COMMAND = "hatdown"
 	def __init__(self, id, *a):
 		HatAction.__init__(self, id, 0, STICK_PAD_MAX - 1)
 
 class HatLeftAction(HatAction):
+	__slots__ = ()
 	COMMAND = "hatleft"
 	def __init__(self, id, *a):
 		HatAction.__init__(self, id, 0, STICK_PAD_MIN + 1)
 	
 class HatRightAction(HatAction):
+	__slots__ = ()
 	COMMAND = "hatright"
 	def __init__(self, id, *a):
 		HatAction.__init__(self, id, 0, STICK_PAD_MAX - 1)
@@ -780,6 +837,7 @@ class WholeHapticAction(HapticEnabledAction):
 	finger moves over pad.
 	MouseAction, CircularModifier, XYAction and BallModifier currently.
 	"""
+	__slots__ = ()
 	def __init__(self):
 		HapticEnabledAction.__init__(self)
 		self.reset_wholehaptic()
@@ -808,6 +866,7 @@ class MouseAction(WholeHapticAction, Action):
 	Controlls mouse movement in either vertical or horizontal direction
 	or scroll wheel.
 	"""
+	__slots__ = ( "_mouse_axis", "_old_pos", "speed", "haptic", "_ax", "_ay" )
 	COMMAND = "mouse"
 	ALIASES = ("trackpad", )
 	HAPTIC_FACTOR = 75.0	# Just magic number
@@ -944,6 +1003,7 @@ class MouseAbsAction(Action):
 	Controlls mouse movement in either vertical or horizontal direction
 	or scroll wheel.
 	"""
+	__slots__ = ( "_mouse_axis", "_old_pos", "speed" )
 	COMMAND = "mouseabs"
 	MOUSE_FACTOR = 0.005	# Just random number to put default sensitivity into sane range
 	
@@ -1011,6 +1071,8 @@ class AreaAction(Action, SpecialAction, OSDEnabledAction):
 	"""
 	Translates pad position to position in specified area of screen.
 	"""
+	__slots__ = ( "orig_position", "coords", "needs_query_screen",
+		"osd_enabled" )
 	SA = COMMAND = "area"
 	
 	def __init__(self, x1, y1, x2, y2):
@@ -1115,6 +1177,7 @@ class AreaAction(Action, SpecialAction, OSDEnabledAction):
 
 
 class RelAreaAction(AreaAction):
+	__slots__ = ()
 	COMMAND = "relarea"
 	
 	def transform_coords(self, mapper):
@@ -1128,6 +1191,7 @@ class RelAreaAction(AreaAction):
 
 
 class WinAreaAction(AreaAction):
+	__slots__ = ()
 	COMMAND = "winarea"
 	
 	def transform_coords(self, mapper):
@@ -1157,6 +1221,7 @@ class WinAreaAction(AreaAction):
 
 
 class RelWinAreaAction(WinAreaAction):
+	__slots__ = ()
 	COMMAND = "relwinarea"
 	
 	def transform_coords(self, mapper):
@@ -1181,6 +1246,7 @@ class RelWinAreaAction(WinAreaAction):
 
 class GyroAction(Action):
 	""" Uses *relative* gyroscope position as input for emulated axes """
+	__slots__ = ( "axes", "speed" )
 	COMMAND = "gyro"
 	
 	def __init__(self, axis1, axis2=None, axis3=None):
@@ -1226,6 +1292,7 @@ class GyroAction(Action):
 
 class GyroAbsAction(HapticEnabledAction, GyroAction):
 	""" Uses *absolute* gyroscope position as input for emulated axes """
+	__slots__ = ( "ir", "_was_oor", "_deadzone_fn", "haptic" )
 	COMMAND = "gyroabs"
 	MOUSE_FACTOR = 0.01	# Just random number to put default sensitivity into sane range
 	
@@ -1298,6 +1365,7 @@ class ResetGyroAction(Action):
 	Asks mapper to search for all GyroAbsActions in profile and adjust offsets
 	so current pad orientation is treated as neutral.
 	"""
+	__slots__ = ()
 	COMMAND = "resetgyro"
 	
 	def button_press(self, mapper):
@@ -1311,6 +1379,7 @@ class ResetGyroAction(Action):
 
 class MultichildAction(Action):
 	""" Mixin with nice looking to_string() method """
+	__slots__ = ( "actions", )
 	
 	def compress(self):
 		self.actions = [ x.compress() for x in self.actions ]
@@ -1348,6 +1417,7 @@ class TiltAction(MultichildAction):
 	Activates one of 6 defined actions based on direction in
 	which controller is tilted or rotated.
 	"""
+	__slots__ = ( "states", "speed" )
 	COMMAND = "tilt"
 	MIN = 0.75
 	
@@ -1424,6 +1494,7 @@ class TrackballAction(Action):
 	ball(trackpad); Never actually instantiated - Exists only to provide
 	backwards compatibility
 	"""
+	__slots__ = ()
 	COMMAND = "trackball"
 	
 	def __new__(cls, speed=None):
@@ -1436,6 +1507,8 @@ class ButtonAction(HapticEnabledAction, Action):
 	Action that outputs as button press and release.
 	Button can be gamepad button, mouse button or keyboard key.
 	"""
+	__slots__ = ( "button", "button2", "_change", "_pressed_key", "_released",
+		"haptic" )
 	COMMAND = "button"
 	SPECIAL_NAMES = {
 		Keys.BTN_LEFT	: "Mouse Left",
@@ -1702,6 +1775,7 @@ class MultiAction(MultichildAction):
 	Two or more actions executed at once.
 	Generated when parsing 'and'
 	"""
+	__slots__ = ()
 	COMMAND = None
 	PROFILE_KEYS = "actions",
 	PROFILE_KEY_PRIORITY = -20	# First possible
@@ -1872,6 +1946,19 @@ class MultiAction(MultichildAction):
 		for a in self.actions: a.trigger(*p)
 	
 	
+	def _compile(method):
+		def compile_method(self, c, *p):
+			for a in self.actions: c.call(a, method, *p)
+		return compile_method
+	
+	compile_axis = _compile("axis")
+	compile_pad = _compile("pad")
+	compile_gyro = _compile("gyro")
+	compile_whole = _compile("whole")
+	compile_trigger = _compile("trigger")
+	del _compile
+	
+	
 	def to_string(self, multiline=False, pad=0):
 		return (" " * pad) + " and ".join([ x.to_string() for x in self.actions ])
 	
@@ -1883,6 +1970,8 @@ class MultiAction(MultichildAction):
 
 
 class DPadAction(MultichildAction, HapticEnabledAction):
+	__slots__ = ( "diagonal_rage", "dpad_state", "side_before", "ranges",
+		"haptic" )
 	COMMAND = "dpad"
 	PROFILE_KEY_PRIORITY = -10	# First possible
 	
@@ -2016,6 +2105,7 @@ class DPadAction(MultichildAction, HapticEnabledAction):
 
 
 class DPad8Action(DPadAction):
+	__slots__ = ()
 	COMMAND = "dpad8"
 	PROFILE_KEYS = ()
 	
@@ -2065,6 +2155,7 @@ class RingAction(MultichildAction):
 	Combining RingAction with two DPad8Actions allows to assign
 	up to 16 different bindings to one pad.
 	"""
+	__slots__ = ( "radius", "inner", "outer", "_radius_m", "_active" )
 	COMMAND = "ring"
 	PROFILE_KEY_PRIORITY = -10	# First possible
 	DEFAULT_RADIUS = 0.5
@@ -2169,6 +2260,8 @@ class XYAction(WholeHapticAction, Action):
 	"""
 	Used for sticks and pads when actions for X and Y axis are different.
 	"""
+	__slots__ = ( "x", "y", "actions", "_old_distance", "_old_pos", "haptic",
+		"big_click", "_ax", "_ay" )
 	COMMAND = "XY"
 	PROFILE_KEYS = ("X", "Y")
 	PROFILE_KEY_PRIORITY = -10	# First possible, but not before MultiAction
@@ -2183,8 +2276,6 @@ class XYAction(WholeHapticAction, Action):
 		self.actions = (self.x, self.y)
 		self._old_distance = 0
 		self._old_pos = None
-		if hasattr(self.x, "add") or hasattr(self.y, "add"):
-			self.add = self._add
 	
 	
 	def get_compatible_modifiers(self):
@@ -2257,8 +2348,7 @@ class XYAction(WholeHapticAction, Action):
 		return self.x.get_previewable() and self.y.get_previewable()
 	
 	
-	def _add(self, mapper, x, y):
-		""" Not always available """
+	def add(self, mapper, x, y):
 		if self.haptic:
 			WholeHapticAction.add(self, mapper, x, y)
 		if hasattr(self.x, "add"):
@@ -2298,6 +2388,21 @@ class XYAction(WholeHapticAction, Action):
 			self.y.axis(mapper, y, what)
 	
 	
+	def compile_whole(self, c, x, y, what):
+		if self.haptic:
+			return False
+		if c.flags & ControllerFlags.HAS_RSTICK and c.what == RIGHT:
+			c.call(self.x, "axis", x, what)
+			c.call(self.y, "axis", y, what)
+			c.emit("mapper.force_event.add(%s)" % (c.const(FE_PAD),))
+		elif c.what in (LEFT, RIGHT, CPAD):
+			c.call(self.x, "pad", x, what)
+			c.call(self.y, "pad", y, what)
+		else:
+			c.call(self.x, "axis", x, what)
+			c.call(self.y, "axis", y, what)
+	
+	
 	def describe(self, context):
 		if self.name: return self.name
 		rv = []
@@ -2338,6 +2443,7 @@ class RelXYAction(XYAction):
 	XYAction with center positioned wherever finger touched first.
 	See https://github.com/kozec/sc-controller/issues/390
 	"""
+	__slots__ = ( "origin_x", "origin_y" )
 	COMMAND = "relXY"
 	
 	def __init__(self, *a, **b):
@@ -2370,6 +2476,8 @@ class TriggerAction(Action, HapticEnabledAction):
 	"""
 	Used for sticks and pads when actions for X and Y axis are different.
 	"""
+	__slots__ = ( "press_level", "release_level", "action", "pressed",
+		"child_is_axis", "haptic" )
 	COMMAND = "trigger"
 	PROFILE_KEYS = "levels",
 	PROFILE_KEY_PRIORITY = -5
@@ -2471,6 +2579,10 @@ class HipfireAction(Action, HapticEnabledAction):
 	Hip fire style trigger setting the two ranges for two different actions
 	allowing activating the fully pressed action without activating partially pressed one
 	"""
+	__slots__ = ( "partialpress_level", "fullpress_level", "mode", "timeout",
+		"partialpress_action", "fullpress_action", "partialpress_active",
+		"range", "waiting_task", "sensible_state", "_partialpress_level",
+		"haptic", "new_partialpress_level" )
 
 	COMMAND = "hipfire"
 	PROFILE_KEYS = "levels",
@@ -2666,6 +2778,7 @@ class NoAction(Action):
 	Parsed from None.
 	Singleton, treated as False in boolean ops.
 	"""
+	__slots__ = ()
 	COMMAND = "None"
 	ALIASES = (None, )
 	_singleton = None
@@ -2699,6 +2812,15 @@ class NoAction(Action):
 	def trigger(self, *a):
 		pass
 	
+	def compile_axis(self, *a):
+		pass
+	
+	def compile_whole(self, *a):
+		pass
+	
+	def compile_trigger(self, *a):
+		pass
+	
 	
 	def describe(self, context):
 		return _("(not set)")
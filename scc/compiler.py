@@ -0,0 +1,169 @@
+#!/usr/bin/env python2
+"""
+SC-Controller - Profile Compiler
+
+Generates one specialised python function for every input (stick, pads,
+triggers and gyro) of profile assigned to mapper, so action tree doesn't
+have to be walked on every event received from controller.
+
+Action class can define compile_<method> (for example compile_whole) next
+to method it mirrors. Such method is called with Compiler instance and
+names of local variables holding arguments, and should emit code that does
+same thing as <method> would do. Returning False or not defining
+compile_<method> causes generated function to simply call <method> of
+that action. compile_<method> is used only if it's defined by same class
+as <method>, so subclass overriding <method> falls back automatically.
+
+Actions are expected not to change once profile is compressed and
+assigned to mapper. Action assigned directly to input may be replaced
+at any time; generated function checks it and compiles itself again.
+"""
+from __future__ import unicode_literals
+from scc.constants import LEFT, RIGHT, CPAD, DPAD, STICK, RSTICK
+
+import logging
+log = logging.getLogger("Compiler")
+
+
+class Compiler(object):
+	""" Generates code of one function """
+	DEBUG = False	# If set, generated code is logged
+	
+	def __init__(self, mapper, what, interpret=False):
+		# Value of 'what' passed to generated function. Code emitted by
+		# compile_* methods has to pass 'what' to child actions unchanged.
+		self.what = what
+		# Controller flags are known at time of compilation; Dispatcher is
+		# reset when mapper gets another controller
+		self.flags = mapper.controller_flags()
+		self.interpret = interpret
+		self.consts = {}
+		self._const_names = {}
+		self._lines = []
+		self._tmp = 0
+	
+	
+	def const(self, value):
+		"""
+		Returns name under which value is available to generated code.
+		"""
+		if id(value) not in self._const_names:
+			name = "c%s" % (len(self.consts),)
+			self.consts[name] = value
+			self._const_names[id(value)] = name
+		return self._const_names[id(value)]
+	
+	
+	def tmp(self):
+		""" Returns name of new local variable """
+		self._tmp += 1
+		return "t%s" % (self._tmp,)
+	
+	
+	def emit(self, line):
+		""" Adds line of code """
+		self._lines.append("\t" + line)
+	
+	
+	@staticmethod
+	def get_compile_method(action, method):
+		"""
+		Returns bound compile_<method> of action or None if action
+		doesn't have one usable for <method>.
+		"""
+		cls = type(action)
+		for c in cls.__mro__:
+			if method in c.__dict__:
+				fn = c.__dict__.get("compile_" + method)
+				if fn is None:
+					return None
+				return fn.__get__(action, cls)
+		return None
+	
+	
+	def call(self, action, method, *args):
+		"""
+		Emits code that does same thing as calling action.<method>(mapper, *args).
+		'args' are names of local variables.
+		"""
+		if not self.interpret:
+			fn = Compiler.get_compile_method(action, method)
+			if fn is not None and fn(self, *args) is not False:
+				return
+		self.emit("%s(mapper, %s)" % (self.const(getattr(action, method)), ", ".join(args)))
+	
+	
+	def build(self, name, parameters, guard):
+		""" Compiles everything emitted so far into function """
+		code = "def %s(%s):\n%s\n" % (name, ", ".join(parameters),
+			"\n".join(guard + (self._lines or [ "\tpass" ])))
+		namespace = dict(self.consts)
+		exec compile(code, "<compiled %s>" % (name,), "exec") in namespace
+		fn = namespace[name]
+		fn.code = code		# for debugging
+		return fn
+
+
+class Dispatcher(object):
+	"""
+	Holds compiled function for every input of one mapper. Function for
+	each input is compiled when it's used for first time.
+	
+	If 'interpret' is set, generated functions just call action assigned
+	to input, as if nothing was compiled.
+	"""
+	
+	INPUTS = {
+		# name:		(method,	action assigned to input,			what)
+		"stick":	("whole",	"mapper.profile.stick",				STICK),
+		"rstick":	("whole",	"mapper.profile.rstick",			RSTICK),
+		"lpad":		("whole",	"mapper.profile.pads[%r]" % (LEFT,),	LEFT),
+		"rpad":		("whole",	"mapper.profile.pads[%r]" % (RIGHT,),	RIGHT),
+		"cpad":		("whole",	"mapper.profile.pads[%r]" % (CPAD,),	CPAD),
+		"dpad":		("whole",	"mapper.profile.pads[%r]" % (DPAD,),	DPAD),
+		"ltrig":	("trigger",	"mapper.profile.triggers[%r]" % (LEFT,),	None),
+		"rtrig":	("trigger",	"mapper.profile.triggers[%r]" % (RIGHT,),	None),
+		"gyro":		("gyro",	"mapper.profile.gyro",				None),
+	}
+	
+	PARAMETERS = {
+		"whole":	("x", "y", "what"),
+		"trigger":	("position", "old_position"),
+		"gyro":		("pitch", "yaw", "roll", "q1", "q2", "q3", "q4"),
+	}
+	
+	def __init__(self, interpret=False):
+		self.interpret = interpret
+		self.reset()
+	
+	
+	def reset(self):
+		""" Drops all compiled functions """
+		for name in Dispatcher.INPUTS:
+			setattr(self, name, self._make_stub(name))
+	
+	
+	def _make_stub(self, name):
+		def stub(mapper, *a):
+			fn = self.compile(mapper, name)
+			setattr(self, name, fn)
+			return fn(mapper, *a)
+		return stub
+	
+	
+	def compile(self, mapper, name):
+		""" Generates function for input with given name """
+		method, expression, what = Dispatcher.INPUTS[name]
+		parameters = Dispatcher.PARAMETERS[method]
+		action = eval(expression, { "mapper" : mapper })
+		c = Compiler(mapper, what, self.interpret)
+		guard = [
+			"\tif %s is not %s:" % (expression, c.const(action)),
+			"\t\treturn %s(mapper, %s)" % (c.const(self._make_stub(name)), ", ".join(parameters)),
+		]
+		c.call(action, method, *parameters)
+		fn = c.build(name, ("mapper",) + parameters, guard)
+		if Compiler.DEBUG:
+			log.debug("Compiled %s:\n%s", name, fn.code)
+		return fn
+
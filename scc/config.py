@@ -2,15 +2,20 @@
 """
 SC-Controller - Config
 
-Handles loading, storing and querying config file
+Handles loading, storing and querying config file.
+
+Code that only reads configuration should use Config.get_shared(), which
+doesn't touch disk unless config file was changed.
 """
 from __future__ import unicode_literals
 
+from scc.lib.inotify import INotify, IN_CLOSE_WRITE, IN_MOVED_TO, IN_DELETE
+from scc.lib.inotify import IN_Q_OVERFLOW, IN_ONLYDIR
 from scc.paths import get_config_path
 from scc.profile import Encoder
 from scc.special_actions import ChangeProfileAction
 
-import os, json, logging
+import os, json, copy, threading, logging
 log = logging.getLogger("Config")
 
 
@@ -78,6 +83,14 @@ class Config(object):
 		# (or only some) inputs.
 		# This enables GUI to display which physical button was pressed to user.
 		"enable_sniffing" : False,
+		# prewarm_profiles - Daemon parses actions of loaded profile only when
+		# they are used for first time. If enabled, all actions are parsed
+		# in background right after profile is loaded instead.
+		"prewarm_profiles" : False,
+		# shell_condition_ttl - Number of seconds for which result of 'shell'
+		# command used as modeshift condition is reused before command
+		# is executed again.
+		"shell_condition_ttl" : 2.0,
 		# Style and colors used by OSD
 		"osd_style": "Classic.gtkstyle.css",
 		"osd_colors": {
@@ -127,11 +140,31 @@ class Config(object):
 	}
 	
 	
+	_shared = None
+	_shared_lock = threading.Lock()
+	
 	def __init__(self):
 		self.filename = os.path.join(get_config_path(), "config.json")
 		self.reload()
 	
 	
+	@staticmethod
+	def get_shared():
+		"""
+		Returns snapshot of configuration shared by whole process.
+		
+		Unlike Config(), this reads config file only on first call and then
+		only after inotify reports that file was changed. Snapshot is not
+		affected by reloading and can be modified, in which case values are
+		copied first, so change is not visible to anyone else. Values
+		retrieved from snapshot should not be modified in place.
+		"""
+		with Config._shared_lock:
+			if Config._shared is None:
+				Config._shared = SharedConfig()
+			return Config._shared.snapshot()
+	
+	
 	def reload(self):
 		""" (Re)loads configuration. Works as load(), but handles exceptions """
 		try:
@@ -219,10 +252,12 @@ class Config(object):
 		# Check & create directory
 		if not os.path.exists(get_config_path()):
 			os.makedirs(get_config_path())
-		# Save
+		# Save. File is replaced atomically, so anything watching it
+		# never reads half-written configuration
 		data = { k:self.values[k] for k in self.values }
 		jstr = Encoder(sort_keys=True, indent=4).encode(data)
-		file(self.filename, "w").write(jstr)
+		file(self.filename + ".tmp", "w").write(jstr)
+		os.rename(self.filename + ".tmp", self.filename)
 		log.debug("Configuration saved")
 	
 	
@@ -243,3 +278,106 @@ class Config(object):
 		""" Returns true if there is such value """
 		return key in self.values
 
+
+
+
+class ConfigSnapshot(Config):
+	"""
+	Copy-on-write view of configuration returned by Config.get_shared.
+	Values are shared with other snapshots until something is changed.
+	"""
+	
+	def __init__(self, values, filename, owned=False):
+		self.filename = filename
+		self.values = values
+		self._owned = owned
+	
+	
+	def _own(self):
+		""" Makes private copy of values before they are modified """
+		if not self._owned:
+			self.values = copy.deepcopy(self.values)
+			self._owned = True
+	
+	
+	def reload(self):
+		self.values = Config.get_shared().values
+		self._owned = False
+	
+	
+	def get_controller_config(self, controller_id):
+		controllers = self.values['controllers']
+		if controller_id not in controllers or any(( key not in controllers[controller_id]
+				for key in self.CONTROLLER_DEFAULTS )):
+			# Defaults are going to be added
+			self._own()
+		return Config.get_controller_config(self, controller_id)
+	
+	
+	def set(self, key, value):
+		self._own()
+		self.values[key] = value
+	
+	__setitem__ = set
+
+
+class SharedConfig(object):
+	""" Keeps configuration loaded and up to date for Config.get_shared """
+	FILENAME = "config.json"
+	
+	def __init__(self):
+		self.filename = os.path.join(get_config_path(), self.FILENAME)
+		self._mtime = None
+		try:
+			if not os.path.exists(get_config_path()):
+				os.makedirs(get_config_path())
+			# Directory is watched, as file is replaced when saved
+			self._inotify = INotify()
+			self._inotify.add_watch(get_config_path(),
+				IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE | IN_ONLYDIR)
+		except (OSError, AttributeError):
+			# AttributeError is thrown when libc doesn't have inotify functions
+			log.warning("Failed to watch configuration file, falling back to checking mtime")
+			self._inotify = None
+			self._changed()
+		# Config() creates directory and default configuration if needed
+		self.values = Config().values
+	
+	
+	def _changed(self):
+		""" Returns True if config file was changed since last check """
+		if self._inotify is None:
+			try:
+				mtime = os.stat(self.filename).st_mtime
+			except OSError:
+				mtime = None
+			changed, self._mtime = mtime != self._mtime, mtime
+			return changed
+		changed = False
+		for event in self._inotify.read_events():
+			if event.mask & IN_Q_OVERFLOW or event.name == self.FILENAME:
+				changed = True
+		return changed
+	
+	
+	def snapshot(self):
+		if self._changed():
+			self.reload()
+		return ConfigSnapshot(self.values, self.filename)
+	
+	
+	def reload(self):
+		"""
+		Loads configuration. Values are replaced, never modified, so
+		already existing snapshots are not affected.
+		If file cannot be loaded, previous values are kept.
+		"""
+		try:
+			values = json.loads(open(self.filename, "r").read())
+		except Exception, e:
+			log.warning("Failed to reload configuration: %s", e)
+			return
+		config = ConfigSnapshot(values, self.filename, True)
+		config.check_values()
+		self.values = config.values
+		log.debug("Configuration reloaded")
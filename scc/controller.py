@@ -132,12 +132,18 @@ class HapticData(object):
 		
 		self.data = data				# send to controller
 		self.frequency = frequency		# used internally
+		self._copies = {}				# cache for with_position
 	
 	
 	def with_position(self, position):
-		""" Creates copy of HapticData with position value changed """
-		trash, amplitude, period, count = self.data
-		return HapticData(position, amplitude, self.frequency, period, count)
+		"""
+		Returns copy of HapticData with position value changed.
+		Copy is created only once, same object is returned on next call.
+		"""
+		if position not in self._copies:
+			trash, amplitude, period, count = self.data
+			self._copies[position] = HapticData(position, amplitude, self.frequency, period, count)
+		return self._copies[position]
 	
 	
 	def get_position(self):
@@ -32,6 +32,11 @@ class DeviceMonitor(Monitor):
 		self.dev_removed_cbs = {}
 		self.bt_addresses = {}
 		self.known_devs = {}
+		# syspath -> (subsystem, vendor, product). vendor and product are
+		# None for devices whose IDs can't be determined. Filled as devices
+		# are seen, so sysfs is read only once per device.
+		self.dev_cache = {}
+		self.hidraw_cache = {}
 	
 	
 	def add_callback(self, subsystem, vendor_id, product_id, added_cb, removed_cb):
@@ -49,6 +54,41 @@ class DeviceMonitor(Monitor):
 		self.dev_removed_cbs[key] = removed_cb
 	
 	
+	def remove_callback(self, subsystem, vendor_id, product_id):
+		""" Removes callbacks added by add_callback """
+		key = (subsystem, vendor_id, product_id)
+		self.dev_added_cbs.pop(key, None)
+		self.dev_removed_cbs.pop(key, None)
+	
+	
+	def add_lazy_callback(self, keys, loader):
+		"""
+		Registers loader that is called when first device matching any of
+		keys, list of (subsystem, vendor_id, product_id) tuples, is detected.
+		
+		Loader is expected to register real callbacks for those keys using
+		add_callback. Device that caused loading is then passed to callback
+		registered by loader, as if it was registered from beginning.
+		"""
+		placeholders = set()
+		
+		def cb(key, syspath, vendor, product):
+			for k in keys:
+				if self.dev_added_cbs.get(k) in placeholders:
+					self.remove_callback(*k)
+			loader()
+			added_cb = self.dev_added_cbs.get(key)
+			if added_cb is None or added_cb in placeholders:
+				return None
+			self.known_devs[syspath] = (vendor, product, self.dev_removed_cbs.get(key))
+			return added_cb(syspath, vendor, product)
+		
+		for key in keys:
+			placeholder = lambda syspath, vendor, product, key=key: cb(key, syspath, vendor, product)
+			placeholders.add(placeholder)
+			self.add_callback(key[0], key[1], key[2], placeholder, None)
+	
+	
 	def add_remove_callback(self, syspath, cb):
 		"""
 		Adds (possibly replaces) callback that will be called once
@@ -68,15 +108,41 @@ class DeviceMonitor(Monitor):
 		Monitor.start(self)
 	
 	
-	def _on_new_syspath(self, subsystem, syspath):
-		try:
-			if subsystem == "input":
-				vendor, product = None, None
-			else:
+	def _get_cached_ids(self, subsystem, syspath, event=None):
+		"""
+		Returns (vendor, product) for given syspath, using IDs sent by udev
+		when possible and reading sysfs only for devices not seen before.
+		Returns (None, None) if IDs cannot be determined.
+		"""
+		if syspath in self.dev_cache:
+			return self.dev_cache[syspath][1:]
+		vendor, product = None, None
+		if event and event.devtype == "usb_device" and event.vendor_id and event.model_id:
+			# Only usb_device itself can be trusted, its interfaces and
+			# subdevices are carrying IDs of parent as well
+			try:
+				vendor, product = int(event.vendor_id, 16), int(event.model_id, 16)
+			except ValueError:
+				pass
+		if vendor is None:
+			try:
 				vendor, product = self.get_vendor_product(syspath, subsystem)
-		except (OSError, IOError):
-			# Cannot grab vendor & product, probably subdevice or bus itself
-			return
+			except (OSError, IOError):
+				# Cannot grab vendor & product, probably subdevice or bus itself
+				if subsystem == "bluetooth":
+					# May be available later, when hci address is known
+					return None, None
+		self.dev_cache[syspath] = (subsystem, vendor, product)
+		return vendor, product
+	
+	
+	def _on_new_syspath(self, subsystem, syspath, event=None):
+		if subsystem == "input":
+			vendor, product = None, None
+		else:
+			vendor, product = self._get_cached_ids(subsystem, syspath, event)
+			if vendor is None:
+				return
 		key = (subsystem, vendor, product)
 		cb = self.dev_added_cbs.get(key)
 		rem_cb = self.dev_removed_cbs.get(key)
@@ -140,17 +206,20 @@ class DeviceMonitor(Monitor):
 		if event:
 			if event.action == "bind" and event.initialized:
 				if event.syspath not in self.known_devs:
-					self._on_new_syspath(event.subsystem, event.syspath)
+					self._on_new_syspath(event.subsystem, event.syspath, event)
 			elif event.action == "add" and event.initialized and event.subsystem in ("input", "bluetooth"):
 				# those are not bound
 				if event.syspath not in self.known_devs:
 					if event.subsystem == "bluetooth":
 						self._get_hci_addresses()
-					self._on_new_syspath(event.subsystem, event.syspath)
+					self._on_new_syspath(event.subsystem, event.syspath, event)
 			elif event.action in ("remove", "unbind") and event.syspath in self.known_devs:
 				vendor, product, cb = self.known_devs.pop(event.syspath)
 				if cb:
 					cb(event.syspath, vendor, product)
+			if event.action == "remove":
+				self.dev_cache.pop(event.syspath, None)
+				self.hidraw_cache.pop(event.syspath, None)
 	
 	
 	def rescan(self):
@@ -168,10 +237,13 @@ class DeviceMonitor(Monitor):
 		
 		for syspath in enumerator:
 			if syspath not in self.known_devs:
-				try:
-					subsystem = DeviceMonitor.get_subsystem(syspath)
-				except (IOError, OSError):
-					continue
+				if syspath in self.dev_cache:
+					subsystem = self.dev_cache[syspath][0]
+				else:
+					try:
+						subsystem = DeviceMonitor.get_subsystem(syspath)
+					except (IOError, OSError):
+						continue
 				if subsystem in subsystem_to_vp_to_callback:
 					self._on_new_syspath(subsystem, syspath)
 	
@@ -211,12 +283,15 @@ class DeviceMonitor(Monitor):
 		For given syspath, returns name of assotiated hidraw device.
 		Returns None if there is no such thing.
 		"""
+		if syspath in self.hidraw_cache:
+			return self.hidraw_cache[syspath]
 		node = self._dev_for_hci(syspath)
 		if node is None:
 			return None
 		hidrawsubdir = os.path.join(node, "hidraw")
 		for fname in os.listdir(hidrawsubdir):
 			if fname.startswith("hidraw"):
+				self.hidraw_cache[syspath] = fname
 				return fname
 		return None
 	
@@ -10,6 +10,10 @@ daemon.remove_controller() to remove Controller instances.
 Additionaly, start(daemon) method is called from each module that defines it
 just before daemon startup is complete.
 
+Drivers listed in LAZY_DRIVERS are not imported at startup. Instead, daemon
+waits until device handled by such driver is detected and only then imports
+module and calls its init and start methods.
+
 Assigning Mapper to Controller is handled by daemon.
 """
 
@@ -19,3 +23,14 @@ MOD_INIT_ORDER = (
 	"scc.drivers.evdevdrv",
 	"scc.drivers.hiddrv"
 )
+
+LAZY_DRIVERS = {
+	# Modules mentioned here are imported only after one of listed
+	# (subsystem, vendor_id, product_id) devices is detected.
+	# Their init method has to register callbacks for same devices.
+	"sc_dongle":	( ("usb", 0x28de, 0x1142), ),
+	"sc_by_cable":	( ("usb", 0x28de, 0x1102), ),
+	"sc_by_bt":		( ("bluetooth", 0x28de, 0x1106), ),
+	"steamdeck":	( ("usb", 0x28de, 0x1205), ),
+	"ds4drv":		( ("usb", 0x054c, 0x09cc), ("bluetooth", 0x054c, 0x09cc) ),
+}
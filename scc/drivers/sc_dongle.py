@@ -234,7 +234,7 @@ class SCController(Controller):
 	
 	def read_serial(self):
 		""" Requests and reads serial number from controller """
-		if Config()["ignore_serials"]:
+		if Config.get_shared()["ignore_serials"]:
 			# Special exception for cases when controller drops instead of
 			# sending serial number. See issue #103
 			self.generate_serial()
@@ -285,7 +285,7 @@ class SCController(Controller):
 	def disconnected(self):
 		# If ignore_serials config option is enabled, fake serial used by this
 		# controller is stored away and reused when next controller is connected
-		if Config()["ignore_serials"]:
+		if Config.get_shared()["ignore_serials"]:
 			self._driver._available_serials.add(self._serial)
 	
 	FORMAT1 = b'>BBBBB13sB2s43x'
@@ -15,7 +15,7 @@ from scc.modifiers import HoldModifier, ModeModifier
 from scc.parser import ActionParser, ParseError
 from scc.menu_data import MenuData, MenuItem
 from scc.profile import Profile
-from scc.lib.vdf import parse_vdf, ensure_list
+from scc.lib.vdf import parse_vdf_file, ensure_list
 
 import logging
 log = logging.getLogger("import.vdf")
@@ -574,8 +574,9 @@ class VDFProfile(Profile):
 		Loads profile from vdf file. Returns self.
 		May raise ValueError.
 		"""
-		data = parse_vdf(open(filename, "r"))
+		data = parse_vdf_file(filename)
 		self.load_data(data)
+		return self
 	
 	
 	def load_data(self, data):
@@ -0,0 +1,324 @@
+#!/usr/bin/env python2
+"""
+SC-Controller - Game Index
+
+Keeps list of applications known to XDG menu and belonging to 'Game'
+category.
+
+List is maintained by scc-daemon, refreshed incrementally (only changed
+.desktop files are parsed again) when inotify reports change in one of
+applications directories, and stored in cache file. OSD menu generator reads
+that file directly instead of scanning all installed applications.
+
+Scanning is done in background thread, so daemon is not blocked by parsing
+all installed applications when it starts.
+"""
+from __future__ import unicode_literals
+
+from scc.lib.inotify import INotify, IN_DIR_CHANGES, IN_CLOSE_WRITE
+from scc.lib.inotify import IN_ONLYDIR, IN_Q_OVERFLOW, IN_IGNORED
+from scc.lib.inotify import IN_DELETE_SELF, IN_MOVE_SELF
+from scc.paths import get_cache_path
+
+import os, io, json, threading, logging
+log = logging.getLogger("GameIndex")
+
+
+class GameIndex(object):
+	VERSION = 1			# Cache file format version
+	SAVE_DELAY = 1.0	# How long to wait with saving after change is detected
+	CATEGORY = "Game"
+	
+	def __init__(self, filename=None):
+		self.filename = filename or GameIndex.get_cache_file()
+		self._daemon = None
+		self._inotify = None
+		self._watches = {}		# wd -> directory
+		self._files = {}		# path -> (mtime, desktop_id, parsed entry or None)
+		self._changed = set()	# directories that has to be scanned again
+		self._lock = threading.Lock()	# guards _watches and _changed
+		self._thread = None
+		self._task = None
+	
+	
+	@staticmethod
+	def get_cache_file():
+		""" Returns path to cache file shared by scc-daemon and OSD """
+		return os.path.join(get_cache_path(), "games.json")
+	
+	
+	@staticmethod
+	def get_application_dirs():
+		"""
+		Returns list of 'applications' directories, ordered by priority,
+		as defined by XDG Base Directory Specification.
+		"""
+		data_home = os.environ.get("XDG_DATA_HOME") or os.path.expanduser("~/.local/share")
+		data_dirs = os.environ.get("XDG_DATA_DIRS") or "/usr/local/share:/usr/share"
+		rv = []
+		for d in [ data_home ] + data_dirs.split(":"):
+			d = os.path.join(d, "applications")
+			if d not in rv:
+				rv.append(d)
+		return rv
+	
+	
+	@staticmethod
+	def read_games(filename=None):
+		"""
+		Returns list of games stored in cache file, as list of dicts with
+		'id', 'name', 'icon' and 'filename' keys, or None if cache file
+		cannot be read.
+		"""
+		try:
+			data = json.loads(open(filename or GameIndex.get_cache_file(), "r").read())
+			if data["version"] != GameIndex.VERSION:
+				return None
+			return data["games"]
+		except Exception:
+			return None
+	
+	
+	@staticmethod
+	def parse_desktop_file(filename):
+		"""
+		Reads [Desktop Entry] group from .desktop file.
+		Returns dict with 'name', 'icon', 'categories' and 'hidden' keys,
+		or None if file doesn't describe application.
+		"""
+		entry, in_group = {}, False
+		for line in io.open(filename, "r", encoding="utf-8", errors="replace"):
+			line = line.strip()
+			if line.startswith("["):
+				if in_group:
+					break
+				in_group = line == "[Desktop Entry]"
+			elif in_group and "=" in line and not line.startswith("#"):
+				key, value = line.split("=", 1)
+				entry[key.strip()] = value.strip()
+		if entry.get("Type") != "Application" or "Name" not in entry:
+			return None
+		name = entry["Name"]
+		for lang in GameIndex._get_languages():
+			if "Name[%s]" % (lang,) in entry:
+				name = entry["Name[%s]" % (lang,)]
+				break
+		return {
+			"name" : name,
+			"icon" : entry.get("Icon"),
+			"categories" : [ x for x in entry.get("Categories", "").split(";") if x ],
+			"hidden" : entry.get("Hidden", "").lower() == "true",
+		}
+	
+	
+	@staticmethod
+	def _get_languages():
+		""" Returns locale names in order used to choose localized Name key """
+		lang = (os.environ.get("LC_ALL") or os.environ.get("LC_MESSAGES")
+				or os.environ.get("LANG") or "")
+		lang = lang.split(".")[0].split("@")[0]
+		if not lang or lang in ("C", "POSIX"):
+			return []
+		if "_" in lang:
+			return [ lang, lang.split("_")[0] ]
+		return [ lang ]
+	
+	
+	def start(self, daemon):
+		"""
+		Starts watching applications directories, then loads cached data
+		and scans them in background thread.
+		"""
+		self._daemon = daemon
+		try:
+			self._inotify = INotify()
+			poller = daemon.get_poller()
+			poller.register(self._inotify.fileno(), poller.POLLIN, self.on_data_ready)
+		except OSError, e:
+			log.warning("Failed to initialize inotify, game list will not be updated: %s", e)
+			self._inotify = None
+		self._changed.update(self.get_application_dirs())
+		self._start_thread(self._initial_scan)
+	
+	
+	def load(self):
+		""" Loads parsed entries from cache file, so only changed files has to be parsed """
+		try:
+			data = json.loads(open(self.filename, "r").read())
+			if data["version"] == GameIndex.VERSION:
+				for path, (mtime, desktop_id, entry) in data["files"].items():
+					self._files[path] = mtime, desktop_id, entry
+		except Exception:
+			# Missing or broken cache file just means that everything is
+			# parsed again
+			self._files = {}
+	
+	
+	def save(self):
+		""" Saves cache file. File is replaced atomically """
+		data = {
+			"version" : GameIndex.VERSION,
+			"games" : self.get_games(),
+			"files" : { path : list(self._files[path]) for path in self._files },
+		}
+		path = os.path.dirname(self.filename)
+		if not os.path.exists(path):
+			os.makedirs(path)
+		tmp = self.filename + ".tmp"
+		with open(tmp, "w") as f:
+			f.write(json.dumps(data))
+		os.rename(tmp, self.filename)
+		log.debug("Game list saved")
+	
+	
+	def get_games(self):
+		"""
+		Returns list of games, as stored in cache file.
+		When same desktop file ID exists in multiple directories,
+		one from directory with higher priority is used.
+		"""
+		by_id = {}
+		for directory in reversed(self.get_application_dirs()):
+			prefix = directory + os.path.sep
+			for path in self._files:
+				if path.startswith(prefix):
+					mtime, desktop_id, entry = self._files[path]
+					by_id[desktop_id] = path, entry
+		rv = []
+		for desktop_id, (path, entry) in by_id.items():
+			if entry and not entry["hidden"] and self.CATEGORY in entry["categories"]:
+				rv.append({
+					"id" : desktop_id,
+					"name" : entry["name"],
+					"icon" : entry["icon"],
+					"filename" : path,
+				})
+		rv.sort(key = lambda x : x["name"].lower())
+		return rv
+	
+	
+	def _watch(self, directory):
+		with self._lock:
+			if self._inotify is None or directory in self._watches.values():
+				return
+			try:
+				wd = self._inotify.add_watch(directory,
+					IN_DIR_CHANGES | IN_CLOSE_WRITE | IN_ONLYDIR)
+				self._watches[wd] = directory
+			except OSError:
+				pass
+	
+	
+	def _scan_directory(self, root, directory):
+		"""
+		Checks all .desktop files in directory and its subdirectories,
+		parsing only new and changed ones.
+		Returns True if anything was changed.
+		"""
+		changed, found = False, set()
+		if os.path.isdir(directory):
+			for path, dirnames, filenames in os.walk(directory, followlinks=True):
+				self._watch(path)
+				for f in filenames:
+					if not f.endswith(".desktop"):
+						continue
+					filename = os.path.join(path, f)
+					try:
+						mtime = os.stat(filename).st_mtime
+					except OSError:
+						continue
+					found.add(filename)
+					if filename in self._files and self._files[filename][0] == mtime:
+						continue
+					desktop_id = os.path.relpath(filename, root).replace(os.path.sep, "-")
+					try:
+						entry = GameIndex.parse_desktop_file(filename)
+					except Exception, e:
+						log.debug("Failed to parse %s: %s", filename, e)
+						entry = None
+					self._files[filename] = mtime, desktop_id, entry
+					changed = True
+		else:
+			# Directory doesn't exist (yet), watch its parent so it's
+			# noticed once it's created
+			parent = os.path.dirname(directory)
+			while parent and not os.path.isdir(parent) and parent != os.path.dirname(parent):
+				parent = os.path.dirname(parent)
+			self._watch(parent)
+		# Forget removed files
+		prefix = directory + os.path.sep
+		for filename in [ x for x in self._files if x.startswith(prefix) and x not in found ]:
+			del self._files[filename]
+			changed = True
+		return changed
+	
+	
+	def _initial_scan(self):
+		self.load()
+		self.rescan()
+	
+	
+	def rescan(self):
+		"""
+		Scans directories reported as changed and saves cache if needed.
+		Called from background thread.
+		"""
+		with self._lock:
+			dirty, self._changed = self._changed, set()
+		changed = False
+		roots = self.get_application_dirs()
+		for directory in dirty:
+			root = ([ r for r in roots if directory == r or directory.startswith(r + os.path.sep) ] or [ None ])[0]
+			if root is not None:
+				changed = self._scan_directory(root, directory) or changed
+		if changed or not os.path.exists(self.filename):
+			try:
+				self.save()
+			except (OSError, IOError), e:
+				log.error("Failed to save game list: %s", e)
+	
+	
+	def _start_thread(self, target):
+		self._thread = threading.Thread(target=target)
+		self._thread.daemon = True
+		self._thread.start()
+	
+	
+	def _on_timer(self, *a):
+		self._task = None
+		if self._thread is not None and self._thread.is_alive():
+			# Previous scan is not finished yet
+			self._schedule()
+		else:
+			self._start_thread(self.rescan)
+	
+	
+	def _schedule(self):
+		if self._task is None:
+			self._task = self._daemon.get_scheduler().schedule(self.SAVE_DELAY, self._on_timer)
+	
+	
+	def on_data_ready(self, *a):
+		roots = self.get_application_dirs()
+		with self._lock:
+			for event in self._inotify.read_events():
+				if event.mask & IN_Q_OVERFLOW:
+					self._changed.update(roots)
+					continue
+				directory = self._watches.get(event.wd)
+				if directory is None:
+					continue
+				if event.mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF):
+					# Watch is gone or points elsewhere now. Forgetting it
+					# allows directory to be watched again once it's
+					# recreated and found by scanning its parent.
+					self._inotify.rm_watch(event.wd)
+					del self._watches[event.wd]
+				if directory in roots or any(( directory.startswith(r + os.path.sep) for r in roots )):
+					self._changed.add(directory)
+				else:
+					# Parent of directory that doesn't exist yet
+					self._changed.update([ r for r in roots if r.startswith(directory + os.path.sep) ])
+			changed = bool(self._changed)
+		if changed:
+			self._schedule()
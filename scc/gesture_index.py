@@ -0,0 +1,162 @@
+#!/usr/bin/env python2
+"""
+SC-Controller - Gesture Index
+
+Finds action assigned to gesture string. Used by GesturesAction.
+Kept apart from scc.gestures, so it can be imported by scc.special_actions.
+"""
+from scc.tools import strip_gesture
+
+
+def gesture_distance(a, b):
+	"""
+	Returns number of characters that has to be removed or inserted to
+	change gesture string 'a' to 'b'. Unlike similarity ratio, that's
+	a metric and so can be used to build BK-tree.
+	"""
+	return _distance(_masks(a), len(a), b)
+
+
+def _masks(a):
+	""" Returns bitmask of positions for every character in 'a' """
+	rv = {}
+	for i, char in enumerate(a):
+		rv[char] = rv.get(char, 0) | (1 << i)
+	return rv
+
+
+def _distance(masks, l, b):
+	"""
+	Computes gesture_distance using bit-parallel longest common
+	subsequence, with 'masks' and 'l' precomputed from first string.
+	"""
+	full = (1 << l) - 1
+	v = full
+	for char in b:
+		u = v & masks.get(char, 0)
+		v = ((v + u) | (v - u)) & full
+	lcs = l - bin(v).count("1")
+	return l + len(b) - 2 * lcs
+
+
+class GestureIndex(object):
+	"""
+	Index of gestures defined by GesturesAction.
+	
+	Gesture strings are stored in trie, so gesture can be recognized
+	while it's being drawn (see GestureMatcher), and in BK-tree, so most
+	similar gesture can be found without comparing against every one.
+	"""
+	
+	def __init__(self, gestures, precision):
+		self.precision = precision
+		self._gestures = dict(gestures)
+		self._trie = {}			# char -> subtrie; None -> action
+		self._tree = None		# (gesture string, { distance : subtree })
+		for gstr in sorted(gestures):
+			node = self._trie
+			for char in gstr:
+				node = node.setdefault(char, {})
+			node[None] = gestures[gstr]
+			self._add(gstr)
+	
+	
+	def _add(self, gstr):
+		if self._tree is None:
+			self._tree = (gstr, {})
+			return
+		node = self._tree
+		while True:
+			d = gesture_distance(gstr, node[0])
+			if d == 0:
+				return
+			if d not in node[1]:
+				node[1][d] = (gstr, {})
+				return
+			node = node[1][d]
+	
+	
+	def matcher(self):
+		""" Returns new GestureMatcher walking this index """
+		return GestureMatcher(self._trie)
+	
+	
+	def find(self, gesture_string, matcher=None):
+		"""
+		Returns action assigned to gesture, gesture with same strokes
+		(ignoring their length) or most similar gesture, in that order.
+		If 'matcher' is given, it has to be fed with same gesture string.
+		Returns None if nothing matches.
+		"""
+		if matcher:
+			action = matcher.get_action()
+		else:
+			action = self._gestures.get(gesture_string)
+			if gesture_string:
+				action = action or self._gestures.get(strip_gesture(gesture_string))
+		return action or self._find_similar(gesture_string)
+	
+	
+	def _find_similar(self, gesture_string):
+		"""
+		Returns action of most similar gesture with similarity ratio
+		at least 'precision', or None.
+		"""
+		if self._tree is None:
+			return None
+		l = len(gesture_string)
+		# Gesture with ratio >= precision can't be more than 'radius' away
+		if self.precision > 0:
+			radius = 2.0 * (1.0 - self.precision) * l / self.precision
+		else:
+			radius = float("inf")
+		best, best_ratio = None, None
+		masks = _masks(gesture_string)
+		stack = [ self._tree ]
+		while stack:
+			gstr, children = stack.pop()
+			d = _distance(masks, l, gstr)
+			total = l + len(gstr)
+			ratio = 1.0 - float(d) / total if total else 1.0
+			if ratio >= self.precision and (best is None or (ratio, gstr) > (best_ratio, best)):
+				best, best_ratio = gstr, ratio
+			for cd in children:
+				if d - radius <= cd <= d + radius:
+					stack.append(children[cd])
+		return None if best is None else self._gestures[best]
+
+
+class GestureMatcher(object):
+	"""
+	Walks GestureIndex trie as gesture is drawn, so exact match is already
+	known at moment when finger is lifted.
+	"""
+	
+	def __init__(self, trie):
+		self._trie = trie
+		self.reset()
+	
+	
+	def reset(self):
+		self._exact = self._trie
+		# Gestures ignoring stroke length are stored with 'i' prefix
+		self._stripped = self._trie.get("i")
+		self._last = None
+	
+	
+	def feed(self, direction):
+		if self._exact is not None:
+			self._exact = self._exact.get(direction)
+		if direction != self._last:
+			self._last = direction
+			if self._stripped is not None:
+				self._stripped = self._stripped.get(direction)
+	
+	
+	def get_action(self):
+		""" Returns action of gesture matched so far or None """
+		action = None
+		for node in (self._exact, self._stripped):
+			if node is not None:
+				action = action or node.get(None)
+		return action
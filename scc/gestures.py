@@ -31,13 +31,14 @@ class GestureDetector(Action):
 	RIGHT		= "R"
 	
 	
-	def __init__(self, up_direction, on_finished):
+	def __init__(self, up_direction, on_finished, matcher=None):
 		Action.__init__(self)
 		# TODO: Configurable resolution
 		self._resolution = 3
 		self._deadzone = 1.0 / self._resolution / self._resolution
 		self._up_direction = up_direction
 		self._on_finished = on_finished
+		self._matcher = matcher		# fed with gesture as it's drawn, see scc.gesture_index
 		self._enabled = False
 		self._positions = []
 		self._result = []
@@ -47,6 +48,14 @@ class GestureDetector(Action):
 		""" GestureDetector doesn't starts do detect anything until this is called """
 		self._enabled = True
 		self._result = [ ]
+		if self._matcher:
+			self._matcher.reset()
+	
+	
+	def _add(self, direction):
+		self._result.append(direction)
+		if self._matcher:
+			self._matcher.feed(direction)
 	
 	
 	def get_string(self):
@@ -96,16 +105,16 @@ class GestureDetector(Action):
 						self._positions.append( (x, y) )
 						while (x, y) != (ox, oy):
 							if x < ox:
-								self._result.append(self.LEFT)
+								self._add(self.LEFT)
 								x += 1
 							elif x > ox:
-								self._result.append(self.RIGHT)
+								self._add(self.RIGHT)
 								x -= 1
 							elif y < oy:
-								self._result.append(self.UP)
+								self._add(self.UP)
 								y += 1
 							elif y > oy:
-								self._result.append(self.DOWN)
+								self._add(self.DOWN)
 								y -= 1
 				else:
 					self._positions.append( (x, y) )
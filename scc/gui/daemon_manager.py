@@ -45,6 +45,10 @@ class DaemonManager(GObject.GObject):
 			As 'event' signal on Controller. Allows for capturing events from
 			all controllers using single signal.
 		
+		index-changed ()
+			Emited when daemon reports that profile or menu was added, removed
+			or modified. Use request_index to get updated list.
+		
 		profile-changed (profile)
 			Emited after profile set for first controller is changed.
 			Profile is filename of currently active profile
@@ -66,6 +70,7 @@ class DaemonManager(GObject.GObject):
 			b"dead"						: (GObject.SignalFlags.RUN_FIRST, None, ()),
 			b"error"					: (GObject.SignalFlags.RUN_FIRST, None, (object,)),
 			b"event"					: (GObject.SignalFlags.RUN_FIRST, None, (object,object,object)),
+			b"index-changed"			: (GObject.SignalFlags.RUN_FIRST, None, ()),
 			b"profile-changed"			: (GObject.SignalFlags.RUN_FIRST, None, (object,)),
 			b"reconfigured"				: (GObject.SignalFlags.RUN_FIRST, None, ()),
 			b"unknown-msg"				: (GObject.SignalFlags.RUN_FIRST, None, (object,)),
@@ -84,6 +89,7 @@ class DaemonManager(GObject.GObject):
 		self._requests = []
 		self._controllers = []			# Ordered as daemon says
 		self._controller_by_id = {}		# Source of memory leak
+		self._index = { "profile" : {}, "menu" : {} }
 	
 	
 	def get_controllers(self):
@@ -236,6 +242,12 @@ class DaemonManager(GObject.GObject):
 				self.emit('profile-changed', self._profile)
 			elif line.startswith("Reconfigured."):
 				self.emit('reconfigured')
+			elif line.startswith("Indexed profile:") or line.startswith("Indexed menu:"):
+				kind, data = line[8:].split(":", 1)
+				mtime, is_override, filename = data.strip().split(" ", 2)
+				self._index[kind][filename] = bool(int(is_override)), float(mtime)
+			elif line.startswith("Index changed."):
+				self.emit('index-changed')
 			elif line.startswith("PID:") or line == "SCCDaemon":
 				# ignore
 				pass
@@ -283,6 +295,23 @@ class DaemonManager(GObject.GObject):
 				DaemonManager.nocallback)
 	
 	
+	def request_index(self, success_cb, error_cb):
+		"""
+		Asks daemon for list of all profiles and menus. When success_cb
+		is called, list can be retrieved using get_index.
+		"""
+		self._index = { "profile" : {}, "menu" : {} }
+		self.request("Index.", success_cb, error_cb)
+	
+	
+	def get_index(self, kind="profile"):
+		"""
+		Returns dict of { filename : (is_override, mtime) } with profiles
+		or menus, as last reported by daemon. 'kind' is "profile" or "menu".
+		"""
+		return dict(self._index[kind])
+	
+	
 	def rescan(self):
 		""" Asks daemon to rescan for new devices """
 		self.request("Rescan.", DaemonManager.nocallback,
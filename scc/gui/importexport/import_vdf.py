@@ -12,7 +12,7 @@ from scc.gui.editor import Editor, ComboSetter
 from scc.tools import get_profiles_path
 from scc.foreign.vdf import VDFProfile
 from scc.foreign.vdffz import VDFFZProfile
-from scc.lib.vdf import parse_vdf
+from scc.lib.vdf import parse_vdf_file
 
 from cStringIO import StringIO
 
@@ -77,7 +77,7 @@ class ImportVdf(object):
 		from there.
 		Calls GLib.idle_add to send loaded data into UI.
 		"""
-		data = parse_vdf(open(filename, "r"))
+		data = parse_vdf_file(filename)
 		# Sanity check
 		if "userroamingconfigstore" not in data: return
 		if "controller_config" not in data["userroamingconfigstore"]: return
@@ -121,7 +121,7 @@ class ImportVdf(object):
 				self._lock.acquire()
 				if os.path.exists(filename):
 					try:
-						data = parse_vdf(open(filename, "r"))
+						data = parse_vdf_file(filename)
 						name = data['appstate']['name']
 					except Exception, e:
 						log.error("Failed to load app manifest for '%s'", gameid)
@@ -176,7 +176,7 @@ class ImportVdf(object):
 					continue
 				log.info("Reading '%s'", filename)
 				try:
-					data = parse_vdf(open(filename, "r"))
+					data = parse_vdf_file(filename)
 					name = data['controller_mappings']['title']
 					GLib.idle_add(self._set_profile_name, index, name, filename)
 					break
@@ -224,6 +224,23 @@ class SVGWidget(Gtk.EventBox):
 		self.image.set_from_pixbuf(self.cache[cache_id])
 	
 	
+	def set_prerendered(self, svg, pixbuf):
+		"""
+		Replaces image with one that was already rendered from svg.
+		Source is kept and rendered again only if different buttons
+		are hilighted.
+		"""
+		self.current_svg = svg
+		self.areas = []
+		self.parse_image()
+		self.cache = OrderedDict()
+		if self.size_override:
+			w, h = self.size_override
+			pixbuf = pixbuf.scale_simple(w, h, GdkPixbuf.InterpType.BILINEAR)
+		self.cache[""] = pixbuf
+		self.hilight({})
+	
+	
 	def get_pixbuf(self):
 		""" Returns pixbuf of current image """
 		return self.image.get_pixbuf()
@@ -283,9 +300,12 @@ class SVGEditor(object):
 	def commit(self):
 		"""
 		Sends modified SVG back to original SVGWidget instance.
+		Does nothing if editor was created from string.
 		
 		Return self.
 		"""
+		if self._svgw is None:
+			return self
 		self._svgw.current_svg = ET.tostring(self._tree)
 		self._svgw.cache = OrderedDict()
 		self._svgw.hilight({})
@@ -71,11 +71,18 @@ class Daemon(object):
 			fd.write(pid + '\n')
 
 	def delpid(self):
-		"""Delete pid file"""
+		"""Delete pid file, unless it was already overwritten by another instance"""
+		try:
+			with open(self.pidfile, 'r') as pidf:
+				if int(pidf.read().strip()) != os.getpid():
+					return
+		except Exception:
+			pass
 		os.remove(self.pidfile)
 
-	def start(self):
-		"""Start the daemon."""
+	def start(self, force=False):
+		"""Start the daemon.
+		If force is True, daemon is started even if another instance is running."""
 
 		# Check for a pidfile to see if the daemon already runs
 		try:
@@ -83,6 +90,8 @@ class Daemon(object):
 				pid = int(pidf.read().strip())
 		except Exception:
 			pid = None
+		if force:
+			pid = None
 
 		if pid:
 			# Check if PID coresponds to running daemon process and fail if yes
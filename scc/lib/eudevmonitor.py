@@ -94,6 +94,8 @@ class Eudev:
 		l.udev_device_get_is_initialized.restype = ctypes.c_int
 		l.udev_device_get_devnum.argtypes = [ ctypes.c_void_p ]
 		l.udev_device_get_devnum.restype = ctypes.c_int
+		l.udev_device_get_property_value.argtypes = [ ctypes.c_void_p, ctypes.c_char_p ]
+		l.udev_device_get_property_value.restype = ctypes.c_char_p
 		l.udev_device_unref.argtypes = [ ctypes.c_void_p ]
 		
 		for name in dir(Enumerator):
@@ -223,7 +225,9 @@ class Monitor:
 	
 	All match_* methods are returning self for chaining
 	"""
-	DeviceEvent = namedtuple("DeviceEvent", "action,node,initialized,subsystem,devtype,syspath,devnum")
+	# vendor_id and model_id are taken from ID_VENDOR_ID and ID_MODEL_ID
+	# properties and are None if udev doesn't know them
+	DeviceEvent = namedtuple("DeviceEvent", "action,node,initialized,subsystem,devtype,syspath,devnum,vendor_id,model_id")
 	
 	def __init__(self, eudev, monitor):
 		self._eudev = eudev
@@ -317,6 +321,8 @@ class Monitor:
 			str(self._eudev._lib.udev_device_get_devtype(dev)),
 			str(self._eudev._lib.udev_device_get_syspath(dev)),
 			self._eudev._lib.udev_device_get_devnum(dev),
+			self._eudev._lib.udev_device_get_property_value(dev, b"ID_VENDOR_ID"),
+			self._eudev._lib.udev_device_get_property_value(dev, b"ID_MODEL_ID"),
 		)
 		
 		self._eudev._lib.udev_device_unref(dev)
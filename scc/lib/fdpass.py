@@ -0,0 +1,106 @@
+#!/usr/bin/env python2
+# -*- coding: utf-8 -*-
+"""
+fdpass.py - sends and receives file descriptors over unix socket
+
+Python 2 socket module has no sendmsg/recvmsg, so this calls libc
+directly and passes descriptors as SCM_RIGHTS ancillary data.
+"""
+
+from ctypes.util import find_library
+import os, ctypes, struct
+
+SOL_SOCKET			= 1
+SCM_RIGHTS			= 1
+MSG_CMSG_CLOEXEC	= 0x40000000
+MAX_FDS				= 253	# SCM_MAX_FD in kernel
+
+_CMSG_HEADER = struct.Struct(b"@Lii")	# cmsg_len, cmsg_level, cmsg_type
+_ALIGN = ctypes.sizeof(ctypes.c_size_t)
+
+
+class iovec(ctypes.Structure):
+	_fields_ = [
+		('iov_base',		ctypes.c_void_p),
+		('iov_len',			ctypes.c_size_t),
+	]
+
+
+class msghdr(ctypes.Structure):
+	_fields_ = [
+		('msg_name',		ctypes.c_void_p),
+		('msg_namelen',		ctypes.c_uint32),
+		('msg_iov',			ctypes.POINTER(iovec)),
+		('msg_iovlen',		ctypes.c_size_t),
+		('msg_control',		ctypes.c_void_p),
+		('msg_controllen',	ctypes.c_size_t),
+		('msg_flags',		ctypes.c_int),
+	]
+
+
+_libc = None
+def _get_libc():
+	global _libc
+	if _libc is None:
+		_libc = ctypes.CDLL(find_library("c"), use_errno=True)
+		_libc.sendmsg.argtypes = [ ctypes.c_int, ctypes.POINTER(msghdr), ctypes.c_int ]
+		_libc.sendmsg.restype = ctypes.c_ssize_t
+		_libc.recvmsg.argtypes = [ ctypes.c_int, ctypes.POINTER(msghdr), ctypes.c_int ]
+		_libc.recvmsg.restype = ctypes.c_ssize_t
+	return _libc
+
+
+def _align(size):
+	return (size + _ALIGN - 1) & ~(_ALIGN - 1)
+
+
+def send_fds(sock, data, fds):
+	"""
+	Sends data and list of file descriptors as one message.
+	Socket should be SOCK_SEQPACKET, so data are not split.
+	Raises OSError on failure.
+	"""
+	if len(fds) > MAX_FDS:
+		raise ValueError("Too many file descriptors")
+	libc = _get_libc()
+	buf = ctypes.create_string_buffer(data, len(data))
+	iov = iovec(ctypes.cast(buf, ctypes.c_void_p), len(data))
+	payload = struct.pack(b"@%si" % (len(fds),), *fds)
+	cmsg = _CMSG_HEADER.pack(_CMSG_HEADER.size + len(payload), SOL_SOCKET, SCM_RIGHTS)
+	cmsg += payload
+	control = ctypes.create_string_buffer(cmsg, _align(len(cmsg)))
+	msg = msghdr(None, 0, ctypes.pointer(iov), 1,
+		ctypes.cast(control, ctypes.c_void_p) if fds else None,
+		len(control) if fds else 0, 0)
+	if libc.sendmsg(sock.fileno(), ctypes.byref(msg), 0) < 0:
+		e = ctypes.get_errno()
+		raise OSError(e, "sendmsg: %s" % (os.strerror(e),))
+
+
+def recv_fds(sock, size, max_fds=MAX_FDS):
+	"""
+	Receives message sent by send_fds. Returns (data, fds) tuple.
+	Received descriptors have close-on-exec flag set.
+	Raises OSError on failure.
+	"""
+	libc = _get_libc()
+	buf = ctypes.create_string_buffer(size)
+	iov = iovec(ctypes.cast(buf, ctypes.c_void_p), size)
+	control = ctypes.create_string_buffer(_align(_CMSG_HEADER.size) + _align(max_fds * 4))
+	msg = msghdr(None, 0, ctypes.pointer(iov), 1,
+		ctypes.cast(control, ctypes.c_void_p), len(control), 0)
+	r = libc.recvmsg(sock.fileno(), ctypes.byref(msg), MSG_CMSG_CLOEXEC)
+	if r < 0:
+		e = ctypes.get_errno()
+		raise OSError(e, "recvmsg: %s" % (os.strerror(e),))
+
+	fds, raw, offset = [], control.raw[0:msg.msg_controllen], 0
+	while offset + _CMSG_HEADER.size <= len(raw):
+		length, level, type = _CMSG_HEADER.unpack_from(raw, offset)
+		if length < _CMSG_HEADER.size:
+			break
+		if level == SOL_SOCKET and type == SCM_RIGHTS:
+			count = (length - _CMSG_HEADER.size) // 4
+			fds += struct.unpack_from(b"@%si" % (count,), raw, offset + _CMSG_HEADER.size)
+		offset += _align(length)
+	return buf.raw[0:r], fds
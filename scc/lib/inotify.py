@@ -0,0 +1,287 @@
+#!/usr/bin/env python2
+# -*- coding: utf-8 -*-
+"""
+inotify.py - watches files and directories for changes using inotify
+
+Copyright (C) 2018 by Kozec
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2 as published by
+the Free Software Foundation
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+"""
+
+from collections import namedtuple
+from ctypes.util import find_library
+import os, ctypes, struct, errno, threading
+
+IN_ACCESS			= 0x00000001
+IN_MODIFY			= 0x00000002
+IN_ATTRIB			= 0x00000004
+IN_CLOSE_WRITE		= 0x00000008
+IN_CLOSE_NOWRITE	= 0x00000010
+IN_OPEN				= 0x00000020
+IN_MOVED_FROM		= 0x00000040
+IN_MOVED_TO			= 0x00000080
+IN_CREATE			= 0x00000100
+IN_DELETE			= 0x00000200
+IN_DELETE_SELF		= 0x00000400
+IN_MOVE_SELF		= 0x00000800
+IN_Q_OVERFLOW		= 0x00004000
+IN_IGNORED			= 0x00008000
+IN_ONLYDIR			= 0x01000000
+IN_ISDIR			= 0x40000000
+
+IN_NONBLOCK			= 0o4000
+IN_CLOEXEC			= 0o2000000
+
+# Everything that changes list of files in directory
+IN_DIR_CHANGES = (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+		| IN_DELETE_SELF | IN_MOVE_SELF)
+# Everything that changes content of file
+IN_FILE_CHANGES = IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF
+
+_EVENT_HEADER = struct.Struct(b"iIII")
+_BUFFER_SIZE = 64 * 1024
+
+_libc = None
+def _get_libc():
+	global _libc
+	if _libc is None:
+		_libc = ctypes.CDLL(find_library("c"), use_errno=True)
+		_libc.inotify_init1.argtypes = [ ctypes.c_int ]
+		_libc.inotify_init1.restype = ctypes.c_int
+		_libc.inotify_add_watch.argtypes = [ ctypes.c_int, ctypes.c_char_p, ctypes.c_uint32 ]
+		_libc.inotify_add_watch.restype = ctypes.c_int
+		_libc.inotify_rm_watch.argtypes = [ ctypes.c_int, ctypes.c_int ]
+		_libc.inotify_rm_watch.restype = ctypes.c_int
+	return _libc
+
+
+class INotify(object):
+	"""
+	Wraps inotify file descriptor.
+	
+	Descriptor is non-blocking, so read_events can be called anytime to
+	check if something has changed, or when select/poll (or GLib mainloop)
+	reports that data is available on fileno().
+	"""
+	Event = namedtuple("Event", "wd,mask,cookie,name,path")
+	
+	def __init__(self):
+		self._libc = _get_libc()
+		self._fd = self._libc.inotify_init1(IN_NONBLOCK | IN_CLOEXEC)
+		if self._fd < 0:
+			e = ctypes.get_errno()
+			raise OSError(e, "inotify_init1: %s" % (os.strerror(e),))
+		self._paths = {}		# wd -> path
+	
+	
+	def __del__(self):
+		try:
+			self.close()
+		except Exception:
+			# May fail when interpreter is shutting down
+			pass
+	
+	
+	def close(self):
+		if self._fd is not None and self._fd >= 0:
+			os.close(self._fd)
+		self._fd = None
+	
+	
+	def fileno(self):
+		return self._fd
+	
+	
+	def add_watch(self, path, mask):
+		"""
+		Starts watching file or directory. Returns watch descriptor.
+		Raises OSError if path cannot be watched.
+		"""
+		bpath = path.encode("utf-8") if type(path) == unicode else path
+		wd = self._libc.inotify_add_watch(self._fd, bpath, mask)
+		if wd < 0:
+			e = ctypes.get_errno()
+			raise OSError(e, "inotify_add_watch: %s" % (os.strerror(e),), path)
+		self._paths[wd] = path
+		return wd
+	
+	
+	def rm_watch(self, wd):
+		if wd in self._paths:
+			del self._paths[wd]
+			self._libc.inotify_rm_watch(self._fd, wd)
+	
+	
+	def read_events(self):
+		"""
+		Returns list of all pending events or empty list if there are none.
+		Never blocks.
+		
+		If kernel event queue overflowed, list will contain event with
+		IN_Q_OVERFLOW set in mask and wd set to -1.
+		"""
+		rv = []
+		while True:
+			try:
+				data = os.read(self._fd, _BUFFER_SIZE)
+			except OSError, e:
+				if e.errno in (errno.EAGAIN, errno.EINTR):
+					return rv
+				raise
+			offset = 0
+			while offset + _EVENT_HEADER.size <= len(data):
+				wd, mask, cookie, length = _EVENT_HEADER.unpack_from(data, offset)
+				offset += _EVENT_HEADER.size
+				name = data[offset:offset + length].rstrip(b"\0")
+				offset += length
+				path = self._paths.get(wd)
+				if mask & IN_IGNORED:
+					# Watch was removed by kernel
+					self._paths.pop(wd, None)
+				rv.append(INotify.Event(wd, mask, cookie, name, path))
+
+
+class DirectoryIndex(object):
+	"""
+	Keeps recursive list of files in one or more directories, kept up to
+	date using inotify. Used where code would otherwise call os.path.exists
+	on many possible filenames.
+	
+	Index is refreshed lazily: pending inotify events are read when index
+	is queried and only directories that reported change are listed again.
+	
+	If inotify is not available, every query lists directories again.
+	
+	Serial is incremented also when any file in index is modified, so caller
+	can use it to cache anything derived from file attributes.
+	
+	Index can be used from multiple threads.
+	"""
+	
+	def __init__(self):
+		try:
+			self._inotify = INotify()
+		except (OSError, AttributeError):
+			# AttributeError is thrown when libc doesn't have inotify functions
+			self._inotify = None
+		self._roots = {}		# root -> set of files relative to root
+		self._watches = {}		# directory -> wd
+		self._watched_by = {}	# directory -> set of roots
+		self._dirty = set()		# roots that has to be listed again
+		self._lock = threading.RLock()
+		self.serial = 0			# incremented every time when index changes
+	
+	
+	def fileno(self):
+		"""
+		Returns inotify file descriptor that becomes readable when something
+		in index changes, or None if inotify is not available.
+		"""
+		if self._inotify is None:
+			return None
+		return self._inotify.fileno()
+	
+	
+	def _watch(self, root, directory):
+		if self._inotify is None:
+			return
+		if directory not in self._watches:
+			try:
+				self._watches[directory] = self._inotify.add_watch(
+					directory, IN_DIR_CHANGES | IN_FILE_CHANGES | IN_ATTRIB | IN_ONLYDIR)
+			except OSError:
+				self._dirty.add(root)
+				return
+		self._watched_by.setdefault(directory, set()).add(root)
+	
+	
+	def _unwatch(self, root):
+		""" Stops watching all directories watched only because of root """
+		for directory in list(self._watched_by):
+			roots = self._watched_by[directory]
+			roots.discard(root)
+			if len(roots) == 0:
+				del self._watched_by[directory]
+				self._inotify.rm_watch(self._watches.pop(directory))
+	
+	
+	def _list(self, root):
+		""" (Re)lists root directory and starts watching it and all subdirectories """
+		self._unwatch(root)
+		files = set()
+		if os.path.isdir(root):
+			for path, dirnames, filenames in os.walk(root, followlinks=True):
+				self._watch(root, path)
+				rel = os.path.relpath(path, root)
+				for f in filenames:
+					files.add(f if rel == "." else os.path.join(rel, f))
+		else:
+			# Root is not there (yet). Nearest existing parent directory is
+			# watched instead, so index knows when root is created.
+			parent = os.path.dirname(root)
+			while parent and not os.path.isdir(parent) and parent != os.path.dirname(parent):
+				parent = os.path.dirname(parent)
+			self._watch(root, parent)
+		if self._roots.get(root) != files:
+			self._roots[root] = files
+			self.serial += 1
+	
+	
+	def refresh(self):
+		"""
+		Processes pending inotify events and re-lists changed directories.
+		Called automatically from get_files and contains.
+		Returns value of serial.
+		"""
+		with self._lock:
+			if self._inotify is None:
+				self._dirty.update(self._roots)
+			else:
+				for event in self._inotify.read_events():
+					if event.mask & IN_Q_OVERFLOW:
+						self._dirty.update(self._roots)
+					elif event.path not in self._watched_by:
+						pass
+					elif event.mask & IN_DIR_CHANGES:
+						self._dirty.update(self._watched_by[event.path])
+					else:
+						# File was modified, list of files is still same
+						self.serial += 1
+			if self._dirty:
+				dirty, self._dirty = self._dirty, set()
+				for root in dirty:
+					self._list(root)
+			return self.serial
+	
+	
+	def get_files(self, root, refresh=True):
+		"""
+		Returns set of all files in root directory and its subdirectories,
+		as paths relative to root. Set should not be modified.
+		
+		If refresh is False, pending changes are not processed. That's
+		usefull when caller queries multiple roots and calls refresh()
+		only once.
+		"""
+		with self._lock:
+			if root not in self._roots:
+				self._list(root)
+			elif refresh:
+				self.refresh()
+			return self._roots[root]
+	
+	
+	def contains(self, root, filename):
+		""" Returns True if root contains file with given relative path """
+		return filename in self.get_files(root)
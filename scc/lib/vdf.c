@@ -0,0 +1,336 @@
+/**
+ * SC-Controller - VDF parser
+ *
+ * Tokenizes and parses VDF (Valve Data Format) files used by Steam to store
+ * controller configurations. Tokenizer follows rules of python's shlex
+ * module in non-posix mode, which was used to do this job before, so
+ * result is same in every case, including all weird ones.
+ *
+ * Parser doesn't build any data structure by itself. Instead, it validates
+ * file and generates flat, NUL-separated stream of operations, which is
+ * turned into python dict by scc/lib/vdf.py:
+ *
+ *   "{" NUL key NUL              - starts new dict stored under key
+ *   "}" NUL                      - closes last started dict
+ *   "=" NUL key NUL value NUL    - stores value under key
+ *
+ * Keys are already lowercased and both keys and values have quotes stripped.
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#define VDF_MODULE_VERSION 1
+#define INITIAL_BUFFER_SIZE 256
+
+enum VDFError {
+	VDF_OK					= 0,
+	VDF_DICT_WITHOUT_KEY	= 1,	// '{' not preceded by key
+	VDF_UNEXPECTED_CLOSE	= 2,	// '}' without '{'
+	VDF_UNCLOSED_DICT		= 3,	// '{' without '}'
+	VDF_NO_CLOSING_QUOTE	= 4,
+	VDF_UNSUPPORTED			= 5,	// Token contains NUL byte. Caller should use python parser
+	VDF_OUT_OF_MEMORY		= 6,
+	VDF_IO_ERROR			= 7,	// Failed to read file, errno is set
+};
+
+typedef struct Buffer {
+	char*		data;
+	size_t		length;
+	size_t		allocated;
+} Buffer;
+
+typedef struct Tokenizer {
+	const char*	pos;
+	const char*	end;
+	Buffer		token;
+} Tokenizer;
+
+enum TokenResult {
+	TOKEN_OK,
+	TOKEN_EOF,
+	TOKEN_ERROR,
+};
+
+
+static bool buffer_ensure(Buffer* b, size_t needed) {
+	if (b->length + needed <= b->allocated)
+		return true;
+	size_t size = (b->allocated > 0) ? b->allocated : INITIAL_BUFFER_SIZE;
+	while (size < b->length + needed)
+		size *= 2;
+	char* data = realloc(b->data, size);
+	if (data == NULL)
+		return false;
+	b->data = data;
+	b->allocated = size;
+	return true;
+}
+
+static inline bool buffer_add_char(Buffer* b, char c) {
+	if (!buffer_ensure(b, 1))
+		return false;
+	b->data[b->length++] = c;
+	return true;
+}
+
+/** Appends string and terminating NUL */
+static inline bool buffer_add_string(Buffer* b, const char* s, size_t length) {
+	if (!buffer_ensure(b, length + 1))
+		return false;
+	memcpy(b->data + b->length, s, length);
+	b->length += length;
+	b->data[b->length++] = 0;
+	return true;
+}
+
+static inline bool is_whitespace(char c) {
+	return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n');
+}
+
+static inline bool is_wordchar(char c) {
+	return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z'))
+			|| ((c >= '0') && (c <= '9')) || (c == '_');
+}
+
+static inline bool is_quote(char c) {
+	return (c == '"') || (c == '\'');
+}
+
+/** Skips everything up to and including end of line */
+static inline void skip_comment(Tokenizer* t) {
+	const char* eol = memchr(t->pos, '\n', t->end - t->pos);
+	t->pos = (eol == NULL) ? t->end : eol + 1;
+}
+
+/**
+ * Reads next token into t->token.
+ * Sets *error and returns TOKEN_ERROR if token cannot be read.
+ */
+static enum TokenResult next_token(Tokenizer* t, int* error) {
+	t->token.length = 0;
+	// Whitespace state
+	while (true) {
+		if (t->pos >= t->end)
+			return TOKEN_EOF;
+		char c = *t->pos;
+		if (is_whitespace(c)) {
+			t->pos ++;
+		} else if (c == '#') {
+			skip_comment(t);
+		} else {
+			break;
+		}
+	}
+
+	char c = *(t->pos++);
+	if (is_quote(c)) {
+		// Quoted string. Quotes are part of token and there is no escaping.
+		const char* closing = memchr(t->pos, c, t->end - t->pos);
+		if (closing == NULL) {
+			*error = VDF_NO_CLOSING_QUOTE;
+			return TOKEN_ERROR;
+		}
+		if (!buffer_ensure(&t->token, closing - t->pos + 2)) {
+			*error = VDF_OUT_OF_MEMORY;
+			return TOKEN_ERROR;
+		}
+		t->token.data[t->token.length++] = c;
+		memcpy(t->token.data + t->token.length, t->pos, closing - t->pos);
+		t->token.length += closing - t->pos;
+		t->token.data[t->token.length++] = c;
+		t->pos = closing + 1;
+		return TOKEN_OK;
+	}
+
+	if (!buffer_add_char(&t->token, c)) {
+		*error = VDF_OUT_OF_MEMORY;
+		return TOKEN_ERROR;
+	}
+	if (!is_wordchar(c)) {
+		// Anything else is single-character token
+		return TOKEN_OK;
+	}
+
+	// Word state. Quotes don't start quoted string here and comment is
+	// skipped without ending token.
+	while (t->pos < t->end) {
+		c = *t->pos;
+		if (is_wordchar(c) || is_quote(c)) {
+			if (!buffer_add_char(&t->token, c)) {
+				*error = VDF_OUT_OF_MEMORY;
+				return TOKEN_ERROR;
+			}
+			t->pos ++;
+		} else if (c == '#') {
+			skip_comment(t);
+		} else {
+			if (is_whitespace(c))
+				t->pos ++;
+			// Anything else is left for next token
+			break;
+		}
+	}
+	return TOKEN_OK;
+}
+
+/** Returns true if token consists only of character c */
+static inline bool token_is(Tokenizer* t, char c) {
+	return (t->token.length == 1) && (t->token.data[0] == c);
+}
+
+/** Strips all quotes from both ends of token, as str.strip('"') does */
+static inline void strip_quotes(const char** s, size_t* length) {
+	while ((*length > 0) && ((*s)[0] == '"')) {
+		(*s) ++;
+		(*length) --;
+	}
+	while ((*length > 0) && ((*s)[*length - 1] == '"'))
+		(*length) --;
+}
+
+
+/**
+ * Parses VDF data and stores generated stream of operations in newly
+ * allocated buffer. Returns VDF_OK or one of error codes.
+ *
+ * On success, *out has to be deallocated using vdf_free.
+ */
+int vdf_parse_buffer(const char* data, size_t length, char** out, size_t* out_length) {
+	Tokenizer t = { data, data + length, { NULL, 0, 0 } };
+	Buffer rv = { NULL, 0, 0 };
+	Buffer key = { NULL, 0, 0 };
+	bool has_key = false;
+	size_t depth = 0;
+	int error = VDF_OK;
+	enum TokenResult r;
+
+	if (!buffer_ensure(&rv, length + INITIAL_BUFFER_SIZE)) {
+		error = VDF_OUT_OF_MEMORY;
+		goto vdf_parse_buffer_end;
+	}
+
+	while ((r = next_token(&t, &error)) == TOKEN_OK) {
+		if (memchr(t.token.data, 0, t.token.length) != NULL) {
+			error = VDF_UNSUPPORTED;
+			break;
+		}
+		if (token_is(&t, '{')) {
+			if (!has_key) {
+				error = VDF_DICT_WITHOUT_KEY;
+				break;
+			}
+			if (!buffer_add_string(&rv, "{", 1) || !buffer_add_string(&rv, key.data, key.length)) {
+				error = VDF_OUT_OF_MEMORY;
+				break;
+			}
+			depth ++;
+			has_key = false;
+		} else if (token_is(&t, '}')) {
+			// Note that key set before '}' is not forgotten
+			if (depth < 1) {
+				error = VDF_UNEXPECTED_CLOSE;
+				break;
+			}
+			if (!buffer_add_string(&rv, "}", 1)) {
+				error = VDF_OUT_OF_MEMORY;
+				break;
+			}
+			depth --;
+		} else {
+			const char* s = t.token.data;
+			size_t l = t.token.length;
+			strip_quotes(&s, &l);
+			if (!has_key) {
+				key.length = 0;
+				if (!buffer_ensure(&key, l + 1)) {
+					error = VDF_OUT_OF_MEMORY;
+					break;
+				}
+				for (size_t i=0; i<l; i++) {
+					char c = s[i];
+					key.data[i] = ((c >= 'A') && (c <= 'Z')) ? c + ('a' - 'A') : c;
+				}
+				key.length = l;
+				has_key = true;
+			} else {
+				if (!buffer_add_string(&rv, "=", 1)
+						|| !buffer_add_string(&rv, key.data, key.length)
+						|| !buffer_add_string(&rv, s, l)) {
+					error = VDF_OUT_OF_MEMORY;
+					break;
+				}
+				has_key = false;
+			}
+		}
+	}
+
+	if ((error == VDF_OK) && (depth > 0))
+		error = VDF_UNCLOSED_DICT;
+
+vdf_parse_buffer_end:
+	free(t.token.data);
+	free(key.data);
+	if (error != VDF_OK) {
+		free(rv.data);
+		return error;
+	}
+	*out = rv.data;
+	*out_length = rv.length;
+	return VDF_OK;
+}
+
+
+/**
+ * Parses VDF file. File is mapped to memory instead of being read.
+ * Returns VDF_OK or one of error codes. If VDF_IO_ERROR is returned,
+ * errno is set.
+ *
+ * On success, *out has to be deallocated using vdf_free.
+ */
+int vdf_parse_file(const char* filename, char** out, size_t* out_length) {
+	struct stat st;
+	int fd = open(filename, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return VDF_IO_ERROR;
+	if (fstat(fd, &st) != 0) {
+		int err = errno;
+		close(fd);
+		errno = err;
+		return VDF_IO_ERROR;
+	}
+	if (st.st_size == 0) {
+		// Empty file can't be mapped
+		close(fd);
+		return vdf_parse_buffer("", 0, out, out_length);
+	}
+
+	void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	int err = errno;
+	close(fd);
+	if (data == MAP_FAILED) {
+		errno = err;
+		return VDF_IO_ERROR;
+	}
+	madvise(data, st.st_size, MADV_SEQUENTIAL);
+	int rv = vdf_parse_buffer((const char*)data, st.st_size, out, out_length);
+	munmap(data, st.st_size);
+	return rv;
+}
+
+
+void vdf_free(char* out) {
+	free(out);
+}
+
+
+const int vdf_module_version(void) {
+	return VDF_MODULE_VERSION;
+}
@@ -16,15 +16,137 @@ You should have received a copy of the GNU General Public License along
 with this program; if not, write to the Free Software Foundation, Inc.,
 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 """
-import shlex
+from StringIO import StringIO
+import shlex, ctypes
+
+VDF_MODULE_VERSION = 1
+ERRORS = {
+	1 : "Dict without key",
+	2 : "'}' without '{'",
+	3 : "'{' without '}'",
+	4 : "No closing quotation",
+}
+VDF_UNSUPPORTED = 5
+VDF_OUT_OF_MEMORY = 6
+VDF_IO_ERROR = 7
+
+_lib = None
+def _get_lib():
+	"""
+	Returns native parser library or False if it's not available,
+	in which case slower python implementation is used.
+	"""
+	global _lib
+	if _lib is None:
+		try:
+			from scc.tools import find_library
+			_lib = find_library("libvdf")
+			if _lib.vdf_module_version() != VDF_MODULE_VERSION:
+				raise OSError("Invalid native module version")
+			c_size_p = ctypes.POINTER(ctypes.c_size_t)
+			c_char_pp = ctypes.POINTER(ctypes.c_void_p)
+			_lib.vdf_parse_buffer.argtypes = [ ctypes.c_char_p, ctypes.c_size_t, c_char_pp, c_size_p ]
+			_lib.vdf_parse_buffer.restype = ctypes.c_int
+			_lib.vdf_parse_file.argtypes = [ ctypes.c_char_p, c_char_pp, c_size_p ]
+			_lib.vdf_parse_file.restype = ctypes.c_int
+			_lib.vdf_free.argtypes = [ ctypes.c_void_p ]
+			_lib.vdf_free.restype = None
+		except (OSError, AttributeError, ImportError):
+			_lib = False
+	return _lib
 
 
 def parse_vdf(fileobj):
 	"""
-	Converts VDF file or file-like object into python dict
+	Converts VDF file, file-like object or string into python dict
 	
 	Throws ValueError if profile cannot be parsed.
 	"""
+	lib = _get_lib()
+	if lib:
+		# shlex accepts string as well
+		data = fileobj if isinstance(fileobj, basestring) else fileobj.read()
+		if type(data) == str:
+			out, length = ctypes.c_void_p(), ctypes.c_size_t()
+			err = lib.vdf_parse_buffer(data, len(data), ctypes.byref(out), ctypes.byref(length))
+			if err != VDF_UNSUPPORTED:
+				return _build(lib, err, out, length)
+		# Unicode or something that native parser can't handle
+		return _parse_vdf_python(StringIO(data))
+	return _parse_vdf_python(fileobj)
+
+
+def parse_vdf_file(filename):
+	"""
+	Converts VDF file into python dict. Unlike parse_vdf, this maps
+	file into memory instead of reading it, if native parser is available.
+	
+	Throws ValueError if profile cannot be parsed and IOError if file
+	cannot be read.
+	"""
+	lib = _get_lib()
+	if lib:
+		out, length = ctypes.c_void_p(), ctypes.c_size_t()
+		bfilename = filename.encode("utf-8") if type(filename) == unicode else filename
+		err = lib.vdf_parse_file(bfilename, ctypes.byref(out), ctypes.byref(length))
+		if err not in (VDF_UNSUPPORTED, VDF_IO_ERROR):
+			return _build(lib, err, out, length)
+		# On IO error, python code is left to raise proper exception
+	return _parse_vdf_python(open(filename, "r"))
+
+
+def _build(lib, err, out, length):
+	"""
+	Builds dict from stream of operations generated by native parser.
+	See scc/lib/vdf.c for description of format.
+	"""
+	if err in ERRORS:
+		raise ValueError(ERRORS[err])
+	elif err == VDF_OUT_OF_MEMORY:
+		raise MemoryError()
+	elif err != 0:
+		raise ValueError("Failed to parse VDF: error %s" % (err,))
+	try:
+		tokens = ctypes.string_at(out, length.value).split(b"\0")
+	finally:
+		lib.vdf_free(out)
+	
+	rv = {}
+	stack = [ rv ]
+	top = rv
+	i, count = 0, len(tokens) - 1	# Last token is always empty
+	while i < count:
+		op = tokens[i]
+		if op == b"=":
+			key, value = tokens[i + 1], tokens[i + 2]
+			if key in top:
+				lst = ensure_list(top[key])
+				lst.append(value)
+				top[key] = lst
+			else:
+				top[key] = value
+			i += 3
+		elif op == b"{":
+			key, value = tokens[i + 1], {}
+			if key in top:
+				lst = ensure_list(top[key])
+				lst.append(value)
+				top[key] = lst
+			else:
+				top[key] = value
+			stack.append(value)
+			top = value
+			i += 2
+		else:	# "}"
+			stack.pop()
+			top = stack[-1]
+			i += 1
+	
+	return rv
+
+
+def _parse_vdf_python(fileobj):
+	""" Python implementation of parse_vdf, used when native one is not available """
 	rv = {}
 	stack = [ rv ]
 	lexer = shlex.shlex(fileobj)
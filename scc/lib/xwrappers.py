@@ -45,6 +45,7 @@ XID = c_ulong
 Pixmap = XID
 Colormap = XID
 Atom = c_ulong
+KeySym = c_ulong
 XserverRegion = c_ulong
 GC = c_void_p
 Display = c_void_p
@@ -253,12 +254,27 @@ shape_combine_mask = libXext.XShapeCombineMask
 shape_combine_mask.__doc__ = "Sets 1-bit transparency mask for window"
 shape_combine_mask.argtypes = [ c_void_p, XID, c_int, c_int, c_int, Pixmap, c_int ]
 
+change_keyboard_mapping = libX11.XChangeKeyboardMapping
+change_keyboard_mapping.__doc__ = "Changes keysyms assigned to keycodes"
+change_keyboard_mapping.argtypes = [ c_void_p, c_int, c_int, POINTER(KeySym), c_int ]
+
+sync = libX11.XSync
+sync.__doc__ = "Flushes request queue and waits until all requests are processed"
+sync.argtypes = [ c_void_p, c_bool ]
+
 
 
 # Wrapped functions
 _xkb_get_state = libX11.XkbGetState
 _xkb_get_state.argtypes = [c_void_p, c_uint, POINTER(XkbStateRec)]
 
+_display_keycodes = libX11.XDisplayKeycodes
+_display_keycodes.argtypes = [ c_void_p, POINTER(c_int), POINTER(c_int) ]
+
+_get_keyboard_mapping = libX11.XGetKeyboardMapping
+_get_keyboard_mapping.argtypes = [ c_void_p, c_ubyte, c_int, POINTER(c_int) ]
+_get_keyboard_mapping.restype = POINTER(KeySym)
+
 # Wrappers
 def get_xkb_state(dpy):
 	rec = XkbStateRec()
@@ -416,3 +432,24 @@ def get_wm_state(dpy, window):
 	count, state = get_window_prop(dpy, window, "_NET_WM_STATE", 1024)
 	if count <= 0: return []
 	return cast(state, POINTER(Atom))[0:count]
+
+
+def get_keyboard_mapping(dpy):
+	"""
+	Returns dict of { keycode: list of keysyms } for all keycodes.
+	Keysyms are ordered as in core protocol, that is
+	(group1, group1+shift, group2, group2+shift, group1+altgr, ...)
+	"""
+	min_keycode, max_keycode, per_keycode = c_int(), c_int(), c_int()
+	_display_keycodes(dpy, byref(min_keycode), byref(max_keycode))
+	count = max_keycode.value - min_keycode.value + 1
+	syms = _get_keyboard_mapping(dpy, min_keycode.value, count, byref(per_keycode))
+	if not syms:
+		return {}
+	per = per_keycode.value
+	rv = {
+		min_keycode.value + i : syms[i * per : (i + 1) * per]
+		for i in xrange(count)
+	}
+	free(syms)
+	return rv
@@ -9,7 +9,8 @@ from __future__ import unicode_literals
 from scc.actions import Action, NoAction, ButtonAction, MOUSE_BUTTONS
 from scc.constants import FE_STICK, FE_TRIGGER, FE_PAD
 from scc.constants import LEFT, RIGHT, STICK, SCButtons
-from scc.uinput import Keys
+from scc.aliases import ALL_BUTTONS as GAMEPAD_BUTTONS
+from scc.uinput import Keys, MacroPlayer
 
 
 import time, logging
@@ -21,7 +22,13 @@ class Macro(Action):
 	"""
 	Two or more actions executed in sequence.
 	Generated when parsing ';'
+	
+	Macro that only presses and releases buttons is compiled to script
+	that's played by MacroPlayer (see scc.uinput) with precise timing.
+	Everything else is played using scheduler.
 	"""
+	__slots__ = ( "actions", "repeat", "hold_time", "_active", "_current",
+		"_release", "_script", "_playing" )
 
 	COMMAND = None
 	HOLD_TIME = 0.01
@@ -43,6 +50,42 @@ class Macro(Action):
 				self.actions.append(p)
 			else:
 				self.actions.append(ButtonAction(p))
+		self._playing = None		# (player, id) while played by MacroPlayer
+		self._script = self._compile()
+	
+	
+	def _compile(self):
+		"""
+		Converts macro to (events, length) tuple that can be played by
+		MacroPlayer. Returns None if macro contains anything else than
+		button presses, releases and sleeps.
+		"""
+		script, t = [], 0.0
+		for a in self.actions:
+			if type(a) == ButtonAction and not a.haptic:
+				button, events = a.button, ( (0, 1), (self.hold_time, 0) )
+			elif type(a) in (PressAction, ReleaseAction):
+				button = a.action
+				if type(button) == ButtonAction and not button.haptic:
+					button = button.button
+				events = ( (0, 1 if type(a) == PressAction else 0), )
+			elif type(a) == SleepAction:
+				button, events = None, ()
+			else:
+				return None
+			if events:
+				if not isinstance(button, Keys):
+					return None
+				if button in MOUSE_BUTTONS:
+					device = MacroPlayer.MOUSE
+				elif button in GAMEPAD_BUTTONS:
+					device = MacroPlayer.GAMEPAD
+				else:
+					device = MacroPlayer.KEYBOARD
+				for offset, value in events:
+					script.append(( int(round((t + offset) * 1000000)), device, button, value ))
+			t += self.hold_time + a.delay_after
+		return MacroPlayer.compile(script), int(round(t * 1000000))
 	
 	
 	def button_press(self, mapper):
@@ -51,19 +94,46 @@ class Macro(Action):
 			# Empty macro
 			return False
 		self._active = True
+		if self._playing is not None:
+			# Already playing, but may be just finishing last repetition
+			player, id = self._playing
+			if player.set_repeat(id, self.repeat):
+				return False
+			# Already finished, only notification was not processed yet
+			self._playing = None
 		if self._current is not None:
 			# Already executing macro
 			return False
+		if self._script:
+			player = mapper.get_macro_player()
+			if player:
+				events, length = self._script
+				id = player.play(events, length, self.repeat, self._on_played)
+				if id is not None:
+					self._playing = player, id
+					return
 		self._current = [] + self.actions
 		self.timer(mapper)
 	
 	
+	def _on_played(self, id, what):
+		""" Called by MacroPlayer when compiled macro is finished or canceled """
+		if what != MacroPlayer.STARTED and self._playing is not None:
+			if self._playing[1] == id:
+				# Notification may be late, after macro was started again
+				self._playing = None
+	
+	
 	def timer(self, mapper):
 		if self._release is None:
 			# Execute next action
 			self._release, self._current = self._current[0], self._current[1:]
-			self._release.button_press(mapper)
-			mapper.schedule(self.hold_time, self.timer)
+			if isinstance(self._release, Type):
+				# Next action has to wait until all text is typed
+				self._release.type(mapper, self.timer)
+			else:
+				self._release.button_press(mapper)
+				mapper.schedule(self.hold_time, self.timer)
 		else:
 			# Finish execited action
 			self._release.button_release(mapper)
@@ -83,6 +153,10 @@ class Macro(Action):
 	
 	
 	def cancel(self, mapper):
+		if self._playing is not None:
+			player, id = self._playing
+			player.cancel(id)
+			self._playing = None
 		for a in self.actions:
 			a.cancel(mapper)
 	
@@ -115,6 +189,9 @@ class Macro(Action):
 	
 	def button_release(self, mapper):
 		self._active = False
+		if self._playing is not None and self.repeat:
+			player, id = self._playing
+			player.set_repeat(id, False)
 	
 	
 	def describe(self, context):
@@ -139,46 +216,51 @@ class Macro(Action):
 	__repr__ = __str__
 
 
-class Type(Macro):
+class Type(Action):
 	"""
-	Special type of Macro where keys to press are specified as string.
-	Basically, writing type("iddqd") is same thing as
-	button(KEY_I) ; button(KEY_D) ; button(KEY_D); button(KEY_Q); button(KEY_D)
+	Types text specified as string, using keyboard layout currently active
+	in X server. Any character available in that layout can be used and
+	characters that are not available are typed using temporary keymap change.
+	
+	Text is sent to keyboard as fast as possible, unless 'delay' is set.
+	With 'delay', one character is typed every 'delay' seconds.
 	
-	Recognizes only lowercase letters, uppercase letters, numbers and space.
-	Adding anything else will make action unparseable.
+	In macro, next action is executed only after whole text is typed.
 	"""
+	__slots__ = ( "letters", "delay" )
 	COMMAND = "type"
-	HOLD_TIME = 0.001
-
-	def __init__(self, string):
-		params = []
-		shift = False
-		for letter in string:
-			if (letter >= 'a' and letter <= 'z') or (letter >= '0' and letter <= '9'):
-				if hasattr(Keys, ("KEY_" + letter).upper()):
-					if shift:
-						params.append(ReleaseAction(Keys.KEY_LEFTSHIFT))
-						shift = False
-					params.append(ButtonAction(getattr(Keys, ("KEY_" + letter).upper())))
-					continue
-			if letter == ' ':
-				params.append(ButtonAction(Keys.KEY_SPACE))
-				continue
-			if letter >= 'A' and letter <= 'Z':
-				if hasattr(Keys, "KEY_" + letter):
-					if not shift:
-						params.append(PressAction(Keys.KEY_LEFTSHIFT))
-						shift = True
-					params.append(ButtonAction(getattr(Keys, "KEY_" + letter)))
-					continue
-			raise ValueError("Invalid character for type(): '%s'" % (letter,))
-		Macro.__init__(self, *params)
+	
+	def __init__(self, string, delay=0):
+		Action.__init__(self, string, delay)
 		self.letters = string
+		self.delay = float(delay)
+	
+	
+	def describe(self, context):
+		if self.name: return self.name
+		return _("Type '%s'") % (self.letters,)
 	
 	
 	def to_string(self, multiline=False, pad=0):
-		return (" " * pad) + self.COMMAND + "(" + repr(self.letters).strip("u") + ")"
+		rv = (" " * pad) + self.COMMAND + "(" + repr(self.letters).strip("u")
+		if self.delay:
+			rv += ", %s" % (self.delay,)
+		return rv + ")"
+	
+	
+	def type(self, mapper, callback=None):
+		"""
+		Types text. If set, callback is called as callback(mapper)
+		once all text is sent to keyboard.
+		"""
+		mapper.text_injector.type(self.letters, self.delay, callback)
+	
+	
+	def button_press(self, mapper):
+		self.type(mapper)
+	
+	
+	def button_release(self, mapper): pass
 
 
 class Cycle(Macro):
@@ -187,6 +269,7 @@ class Cycle(Macro):
 	When button is pressed 1st time, 1st action is executed. 2nd action is
 	executed for 2nd press et cetera et cetera.
 	"""
+	__slots__ = ()
 
 	COMMAND = 'cycle'
 	
@@ -194,6 +277,7 @@ class Cycle(Macro):
 		Action.__init__(self, *parameters)
 		self.actions = parameters
 		self._current = 0
+		self._playing = None
 	
 	
 	def button_press(self, mapper):
@@ -230,6 +314,7 @@ class Repeat(Macro):
 	Repeats specified action as long as physical button is pressed.
 	This is actually just Macro with 'repeat' set to True
 	"""
+	__slots__ = ()
 	COMMAND = "repeat"
 	def __new__(cls, action):
 		if not isinstance(action, Macro):
@@ -243,6 +328,7 @@ class SleepAction(Action):
 	Does nothing.
 	If used in macro, overrides delay after itself.
 	"""
+	__slots__ = ( "delay", )
 	COMMAND = "sleep"
 	def __init__(self, delay):
 		Action.__init__(self, delay)
@@ -271,6 +357,7 @@ class PressAction(Action):
 	Presses button and leaves it pressed.
 	Can be used anywhere, but makes sense only with macro.
 	"""
+	__slots__ = ( "action", )
 	COMMAND = "press"
 	PR = _("Press")
 
@@ -307,6 +394,7 @@ class ReleaseAction(PressAction):
 	Releases button.
 	Can be used anywhere, but makes sense only with macro.
 	"""
+	__slots__ = ()
 	COMMAND = "release"
 	PR = _("Release")
 	
@@ -320,6 +408,7 @@ class TapAction(PressAction):
 	If button is already pressed, generates release-press-release-press
 	events in quick sequence.
 	"""
+	__slots__ = ( "_lst", "_keep_pressed", "button", "count" )
 	COMMAND = "tap"
 	PR = _("Tap")
 	PAUSE = 0.1
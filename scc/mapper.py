@@ -3,7 +3,7 @@ from __future__ import unicode_literals
 
 from collections import deque
 from scc.lib import xwrappers as X
-from scc.uinput import UInput, Keyboard, Mouse, Dummy, Rels
+from scc.uinput import UInput, Keyboard, Mouse, Dummy, Rels, MacroPlayer
 from scc.constants import FE_STICK, FE_TRIGGER, FE_PAD, GYRO, STICK, RSTICK
 from scc.constants import SCButtons, LEFT, RIGHT, CPAD, DPAD, HapticPos
 from scc.constants import STICK_PAD_MAX, STICKTILT, ControllerFlags
@@ -11,7 +11,9 @@ from scc.aliases import ALL_AXES, ALL_BUTTONS
 from scc.actions import ButtonAction, GyroAbsAction
 from scc.controller import HapticData
 from scc.config import Config
-from scc.profile import Profile
+from scc.profile import Profile, LazyAction
+from scc.compiler import Dispatcher
+from scc.text_injector import TextInjector
 
 
 import traceback, logging, time, os
@@ -33,6 +35,7 @@ class Mapper(object):
 		self.controller = None
 		self.xdisplay = None
 		self.scheduler = scheduler
+		self.poller = poller
 		
 		# Create virtual devices
 		log.debug("Creating virtual devices")
@@ -47,7 +50,9 @@ class Mapper(object):
 		# from scc.special_actions
 		self._sa_handler = None
 		
-		# Setup emulation
+		# Setup emulation. All lists and sets here are allocated only once
+		# and cleared in place after every input, so processing input
+		# doesn't keep garbage collector busy.
 		self.keypress_list = []
 		self.keyrelease_list = []
 		self.mouse_movements = [0, 0, 0, 0]		# mouse x, y, wheel vertical, horisontal
@@ -58,6 +63,13 @@ class Mapper(object):
 		self.lpad_touched = False
 		self.state, self.old_state = None, None
 		self.force_event = set()
+		self._force_event_back = set()			# swapped with force_event on every input
+		# Functions generated from actions assigned to stick, pads,
+		# triggers and gyro. See scc.compiler
+		self.compiled = Dispatcher()
+		self.text_injector = TextInjector(self)
+		# Plays compiled macros, see get_macro_player
+		self.macro_player = None
 	
 	
 	def create_gamepad(self, enabled, poller):
@@ -67,7 +79,7 @@ class Mapper(object):
 			# If set, no gamepad is emulated
 			self.gamepad = Dummy()
 			return
-		cfg = Config()
+		cfg = Config.get_shared()
 		keys = ALL_BUTTONS[0:cfg["output"]["buttons"]]
 		vendor = int(cfg["output"]["vendor"], 16)
 		product = int(cfg["output"]["product"], 16)
@@ -128,12 +140,14 @@ class Mapper(object):
 		if len(self.syn_list):
 			for dev in self.syn_list:
 				dev.synEvent()
-			self.syn_list = set()
+			self.syn_list.clear()
 	
 	
 	def set_controller(self, c):
 		""" Sets controller device, used by some (one so far) actions """
 		self.controller = c
+		# Generated code depends on controller flags
+		self.compiled.reset()
 	
 	
 	def get_controller(self):
@@ -157,6 +171,22 @@ class Mapper(object):
 		return self.xdisplay
 	
 	
+	def get_macro_player(self):
+		"""
+		Returns MacroPlayer used to play compiled macros on virtual devices
+		or None if it's not available. Player is created on first use.
+		"""
+		if self.macro_player is None:
+			self.macro_player = False
+			if self.poller:
+				try:
+					self.macro_player = MacroPlayer(self.poller,
+						self.keyboard, self.mouse, self.gamepad)
+				except Exception, e:
+					log.warning("Failed to start macro player, macros will be played by scheduler: %s", e)
+		return self.macro_player or None
+	
+	
 	def get_current_window(self):
 		"""
 		Returns window id of current window or None if xdisplay is not set
@@ -331,11 +361,51 @@ class Mapper(object):
 		Sends button release event for every virtual button that is still being
 		pressed.
 		"""
+		if self.macro_player:
+			# Cancels everything; New player is started when needed
+			self.macro_player.close()
+			self.macro_player = None
 		to_release, self.pressed = self.pressed, {}
 		for x in to_release:
 			ButtonAction._button_release(self, x, True)
 	
 	
+	def switch_profile(self, profile, unwrap=None):
+		"""
+		Switches to new, already compressed profile.
+		'unwrap' is passed to Profile.reuse_actions.
+		
+		Actions that are bound identically in both old and new profile are
+		kept together with their state, so held buttons, gyro references or
+		rolling balls are not interrupted. Only changed actions are cancelled
+		and only virtual buttons not used by any kept action are released.
+		
+		Returns number of kept actions.
+		"""
+		kept, dropped = profile.reuse_actions(self.profile, unwrap)
+		for a in dropped:
+			a.cancel(self)
+		
+		used = set()
+		for a in kept:
+			if isinstance(a, LazyAction) and not a.is_loaded():
+				# Action that was never used couldn't press anything
+				continue
+			for child in a.get_all_actions():
+				used.add(getattr(child, "button", None))
+				used.add(getattr(child, "button2", None))
+		to_release = [ x for x in self.pressed if x not in used ]
+		for x in to_release:
+			del self.pressed[x]
+			ButtonAction._button_release(self, x, True)
+		if dropped:
+			# Reset mouse (issue #222)
+			self.mouse.reset()
+		
+		self.profile = profile
+		return len(kept)
+	
+	
 	def cancel_all(self):
 		"""
 		Called when profile is changed to let all actions to cancel
@@ -362,8 +432,10 @@ class Mapper(object):
 		if self.buttons & SCButtons.LPAD and not self.buttons & (SCButtons.LPADTOUCH | STICKTILT):
 			self.buttons = (self.buttons & ~SCButtons.LPAD) | SCButtons.STICKPRESS
 		
+		# Events forced while processing this input are handled on next one
 		fe = self.force_event
-		self.force_event = set()
+		self.force_event, self._force_event_back = self._force_event_back, fe
+		self.force_event.clear()
 		
 		# Check buttons
 		xor = self.old_buttons ^ self.buttons
@@ -383,57 +455,57 @@ class Mapper(object):
 			# Check sticks
 			if self.controller.flags & ControllerFlags.SEPARATE_STICK:
 				if FE_STICK in fe or self.old_state.stick_x != state.stick_x or self.old_state.stick_y != state.stick_y:
-					self.profile.stick.whole(self, state.stick_x, state.stick_y, STICK)
+					self.compiled.stick(self, state.stick_x, state.stick_y, STICK)
 			elif not self.buttons & SCButtons.LPADTOUCH:
 				if FE_STICK in fe or self.old_state.lpad_x != state.lpad_x or self.old_state.lpad_y != state.lpad_y:
-					self.profile.stick.whole(self, state.lpad_x, state.lpad_y, STICK)
+					self.compiled.stick(self, state.lpad_x, state.lpad_y, STICK)
 			if self.controller.flags & ControllerFlags.IS_DECK:
 				if FE_STICK in fe or self.old_state.rstick_x != state.rstick_x or self.old_state.rstick_y != state.rstick_y:
-					self.profile.rstick.whole(self, state.rstick_x, state.rstick_y, RSTICK)
+					self.compiled.rstick(self, state.rstick_x, state.rstick_y, RSTICK)
 			
 			# Check gyro
 			if controller.get_gyro_enabled():
-				self.profile.gyro.gyro(self, state.gpitch, state.gyaw, state.groll, state.q1, state.q2, state.q3, state.q4)
+				self.compiled.gyro(self, state.gpitch, state.gyaw, state.groll, state.q1, state.q2, state.q3, state.q4)
 			
 			# Check triggers
 			if FE_TRIGGER in fe or state.ltrig != self.old_state.ltrig:
 				if LEFT in self.profile.triggers:
-					self.profile.triggers[LEFT].trigger(self, state.ltrig, self.old_state.ltrig)
+					self.compiled.ltrig(self, state.ltrig, self.old_state.ltrig)
 			if FE_TRIGGER in fe or state.rtrig != self.old_state.rtrig:
 				if RIGHT in self.profile.triggers:
-					self.profile.triggers[RIGHT].trigger(self, state.rtrig, self.old_state.rtrig)
+					self.compiled.rtrig(self, state.rtrig, self.old_state.rtrig)
 			
 			# Check pads
 			# RPAD
 			if controller.flags & ControllerFlags.HAS_RSTICK:
 				if FE_PAD in fe or self.old_state.rpad_x != state.rpad_x or self.old_state.rpad_y != state.rpad_y:
-					self.profile.pads[RIGHT].whole(self, state.rpad_x, state.rpad_y, RIGHT)
+					self.compiled.rpad(self, state.rpad_x, state.rpad_y, RIGHT)
 			elif FE_PAD in fe or self.buttons & SCButtons.RPADTOUCH or SCButtons.RPADTOUCH & btn_rem:
-				self.profile.pads[RIGHT].whole(self, state.rpad_x, state.rpad_y, RIGHT)
+				self.compiled.rpad(self, state.rpad_x, state.rpad_y, RIGHT)
 			# DPAD
 			if controller.flags & ControllerFlags.IS_DECK:
 				if FE_PAD in fe or self.old_state.dpad_x != state.dpad_x or self.old_state.dpad_y != state.dpad_y:
-					self.profile.pads[DPAD].whole(self, state.dpad_x, state.dpad_y, DPAD)
+					self.compiled.dpad(self, state.dpad_x, state.dpad_y, DPAD)
 			
 			# LPAD
 			if self.controller.flags & ControllerFlags.SEPARATE_STICK:
 				if FE_PAD in fe or self.old_state.lpad_x != state.lpad_x or self.old_state.lpad_y != state.lpad_y:
-					self.profile.pads[LEFT].whole(self, state.lpad_x, state.lpad_y, LEFT)
+					self.compiled.lpad(self, state.lpad_x, state.lpad_y, LEFT)
 			else:
 				if self.buttons & SCButtons.LPADTOUCH:
 					# Pad is being touched now
 					if not self.lpad_touched:
 						self.lpad_touched = True
-					self.profile.pads[LEFT].whole(self, state.lpad_x, state.lpad_y, LEFT)
+					self.compiled.lpad(self, state.lpad_x, state.lpad_y, LEFT)
 					if self.old_state.buttons & STICKTILT and not self.buttons & STICKTILT:
 						# LPAD and stick share axes and so when they are used simultaneously (by someone with 3 hands or so :)
 						# this is how mapper can tell that stick was recentered
-						self.profile.stick.whole(self, 0, 0, STICK)
+						self.compiled.stick(self, 0, 0, STICK)
 				elif not self.buttons & STICKTILT:
 					# Pad is not being touched
 					if self.lpad_touched:
 						self.lpad_touched = False
-						self.profile.pads[LEFT].whole(self, 0, 0, LEFT)
+						self.compiled.lpad(self, 0, 0, LEFT)
 					
 			# CPAD (touchpad on DS4 controller)
 			if controller.flags & ControllerFlags.HAS_CPAD:
@@ -443,9 +515,9 @@ class Mapper(object):
 						or ((self.old_buttons & SCButtons.CPADTOUCH) and not (self.buttons & SCButtons.CPADTOUCH))
 					):
 					if self.buttons & SCButtons.CPADTOUCH:
-						self.profile.pads[CPAD].whole(self, state.cpad_x, state.cpad_y, CPAD)
+						self.compiled.cpad(self, state.cpad_x, state.cpad_y, CPAD)
 					elif self.old_buttons & SCButtons.CPADTOUCH:
-						self.profile.pads[CPAD].whole(self, 0, 0, CPAD)
+						self.compiled.cpad(self, 0, 0, CPAD)
 		except Exception:
 			# Log error but don't crash here, it breaks too many things at once
 			if hasattr(self, "_testing"):
@@ -463,19 +535,20 @@ class Mapper(object):
 		# Generate events - keys
 		if len(self.keypress_list):
 			self.keyboard.pressEvent(self.keypress_list)
-			self.keypress_list = []
+			del self.keypress_list[:]
 		if len(self.keyrelease_list):
 			self.keyboard.releaseEvent(self.keyrelease_list)
-			self.keyrelease_list = []
+			del self.keyrelease_list[:]
 		# Generate events - mouse
-		mx, my, wx, wy = self.mouse_movements
+		mm = self.mouse_movements
+		mx, my, wx, wy = mm
 		if mx != 0 or my != 0:
 			self.mouse.moveEvent(mx, my * -1)
 			self.syn_list.add(self.mouse)
 		if wx != 0 or wy != 0:
 			self.mouse.scrollEvent(wx, wy)
 			self.syn_list.add(self.mouse)
-		self.mouse_movements = [ 0, 0, 0, 0 ]
+		mm[0] = mm[1] = mm[2] = mm[3] = 0
 		self.sync()
 	
 	
@@ -27,6 +27,7 @@ log = logging.getLogger("Modifiers")
 _ = lambda x : x
 
 class Modifier(Action):
+	__slots__ = ( "action", )
 	def __init__(self, *params):
 		Action.__init__(self, *params)
 		params = list(params)
@@ -124,6 +125,7 @@ class NameModifier(Modifier):
 	Simple modifier that sets name for child action.
 	Used internally.
 	"""
+	__slots__ = ()
 	COMMAND = "name"
 	
 	def _mod_init(self, name):
@@ -171,6 +173,7 @@ class NameModifier(Modifier):
 
 
 class ClickModifier(Modifier):
+	__slots__ = ()
 	# TODO: Rename to 'clicked'
 	COMMAND = "click"
 	
@@ -286,6 +289,7 @@ class ClickModifier(Modifier):
 
 
 class TouchedModifier(Modifier):
+	__slots__ = ()
 	COMMAND = "touched"
 	
 	
@@ -316,6 +320,7 @@ class TouchedModifier(Modifier):
 
 
 class UntouchedModifier(TouchedModifier):
+	__slots__ = ()
 	COMMAND = "untouched"
 	
 	
@@ -326,6 +331,7 @@ class UntouchedModifier(TouchedModifier):
 
 
 class PressedModifier(Modifier):
+	__slots__ = ()
 	COMMAND = "pressed"
 	
 	
@@ -359,6 +365,7 @@ class PressedModifier(Modifier):
 
 
 class ReleasedModifier(PressedModifier):
+	__slots__ = ()
 	COMMAND = "released"
 	
 	def describe(self, context):
@@ -386,6 +393,9 @@ class BallModifier(Modifier, WholeHapticAction):
 	Target action has to have add(x, y) method defined.
 	
 	"""
+	__slots__ = ( "speed", "friction", "_xvel", "_yvel", "_a", "_ampli",
+		"_degree", "_r", "_radscale", "_mass", "_roll_task", "_I", "_xvel_dq",
+		"_yvel_dq", "_lastTime", "_old_pos", "haptic", "_ax", "_ay" )
 	COMMAND = "ball"
 	PROFILE_KEY_PRIORITY = -6
 	HAPTIC_FACTOR = 60.0	# Just magic number
@@ -607,6 +617,7 @@ class BallModifier(Modifier, WholeHapticAction):
 
 
 class DeadzoneModifier(Modifier):
+	__slots__ = ( "mode", "_convert", "lower", "upper" )
 	COMMAND = "deadzone"
 	JUMP_HARDCODED_LIMIT = 5
 	
@@ -781,11 +792,20 @@ class DeadzoneModifier(Modifier):
 		return self.action.whole(mapper, x, y, what)
 	
 	
+	def compile_whole(self, c, x, y, what):
+		tx, ty = c.tmp(), c.tmp()
+		c.emit("%s, %s = %s(%s, %s, %r)" % (tx, ty, c.const(self._convert),
+			x, y, STICK_PAD_MAX))
+		c.call(self.action, "whole", tx, ty, what)
+	
+	
 	def gyro(self, mapper, pitch, yaw, roll, q1, q2, q3, q4):
 		return self.action.gyro(mapper, pitch, yaw, roll, q1, q2, q3, q4)
 
 
 class ModeModifier(Modifier):
+	__slots__ = ( "default", "mods", "held_buttons", "held_sticks",
+		"held_triggers", "old_action", "shell_commands", "timeout", "checks" )
 	COMMAND = "mode"
 	PROFILE_KEYS = ("modes",)
 	MIN_TRIGGER = 2		# When trigger is bellow this position, list of held_triggers is cleared
@@ -803,7 +823,6 @@ class ModeModifier(Modifier):
 		self.held_triggers = {}
 		self.old_action = None
 		self.shell_commands = {}
-		self.shell_timeout = 0.5
 		self.timeout = DoubleclickModifier.DEAFAULT_TIMEOUT
 		
 		# ShellCommandAction cannot be imported normally, it would create
@@ -835,17 +854,23 @@ class ModeModifier(Modifier):
 	
 	
 	def make_checks(self):
+		"""
+		Generates list of (mask, check, action) tuples, in same order
+		as conditions are tested. Button conditions are tested by
+		masking mapper.buttons with 'mask', 'check' is called only
+		where 'mask' is zero.
+		"""
 		self.checks = []
 		self.shell_commands = {}
 		ShellCommandAction = Action.ALL['shell']
 		for c, action in self.mods.items():
 			if isinstance(c, RangeOP):
-				self.checks.append(( c, action ))
+				self.checks.append(( 0, c, action ))
 			elif isinstance(c, ShellCommandAction):
 				self.shell_commands[c.command] = c
-				self.checks.append(( self.make_shell_check(c), action ))
+				self.checks.append(( 0, self.make_shell_check(c), action ))
 			else:
-				self.checks.append(( self.make_button_check(c), action ))
+				self.checks.append(( int(c), self.make_button_check(c), action ))
 	
 	
 	def get_child_actions(self):
@@ -956,8 +981,12 @@ class ModeModifier(Modifier):
 		"""
 		Selects action by pressed button.
 		"""
-		for check, action in self.checks:
-			if check(mapper):
+		buttons = mapper.buttons
+		for mask, check, action in self.checks:
+			if mask:
+				if buttons & mask:
+					return action
+			elif check(mapper):
 				return action
 		return self.default
 	
@@ -966,8 +995,12 @@ class ModeModifier(Modifier):
 		"""
 		As select, but returns matched check as well.
 		"""
-		for check, action in self.checks:
-			if check(mapper):
+		buttons = mapper.buttons
+		for mask, check, action in self.checks:
+			if mask:
+				if buttons & mask:
+					return check, action
+			elif check(mapper):
 				return check, action
 		return lambda *a:True, self.default
 	
@@ -983,62 +1016,26 @@ class ModeModifier(Modifier):
 	
 	@staticmethod
 	def make_shell_check(c):
+		# https://github.com/kozec/sc-controller/issues/427
+		# 'shell' condition is true if command returned zero exit code.
+		# Commands are executed on background by special actions
+		# handler (daemon) and check only asks for last known result.
 		def cb(mapper):
-			try:
-				return c.__proc.poll() == 0
-			except:
-				return False
+			sa = mapper.get_special_actions_handler()
+			if hasattr(sa, "on_sa_shell_condition"):
+				return sa.on_sa_shell_condition(mapper, c)
+			return False
 		
 		c.name = cb.name = c.to_string()	# So nameof() still works on keys in self.mods
-		c.__proc = None
 		return cb
 	
 	
 	def button_press(self, mapper):
-		if len(self.shell_commands) > 0:
-			# https://github.com/kozec/sc-controller/issues/427
-			# If 'shell' is used as any condition, all shell commands
-			# are executed and ModeShift waits up to 500ms for them
-			# to terminate. Then, if command returned zero exit code
-			# it's considered as 'true' condition.
-			for c in self.shell_commands.values():
-				c.__proc = c.button_press(mapper)
-			self.shell_timeout = 0.5
-			mapper.schedule(0, self.check_shell_commands)
-			return
-		
 		sel = self.select(mapper)
 		self.held_buttons.add(sel)
 		return sel.button_press(mapper)
 	
 	
-	def check_shell_commands(self, mapper):
-		for c in self.shell_commands.values():
-			if c.__proc and c.__proc.poll() == 0:
-				sel = self.select(mapper)
-				self.kill_shell_commands()
-				self.held_buttons.add(sel)
-				return sel.button_press(mapper)
-		
-		self.shell_timeout -= 0.05
-		if self.shell_timeout > 0:
-			mapper.schedule(0.05, self.check_shell_commands)
-		else:
-			# time is up, kill all processes and execute what's left
-			self.kill_shell_commands()
-			sel = self.select(mapper)
-			self.held_buttons.add(sel)
-			return sel.button_press(mapper)
-	
-	
-	def kill_shell_commands(self):
-		for c in self.shell_commands.values():
-			try:
-				if c.__proc: c.__proc.kill()
-			except: pass
-			c.__proc = None
-	
-	
 	def button_release(self, mapper):
 		# Releases all held buttons, not just button that matches
 		# currently pressed modifier
@@ -1106,6 +1103,8 @@ class ModeModifier(Modifier):
 
 
 class DoubleclickModifier(Modifier, HapticEnabledAction):
+	__slots__ = ( "normalaction", "holdaction", "actions", "timeout",
+		"waiting_task", "pressed", "active", "haptic" )
 	COMMAND = "doubleclick"
 	DEAFAULT_TIMEOUT = 0.2
 	TIMEOUT_KEY = "time"
@@ -1262,6 +1261,7 @@ class DoubleclickModifier(Modifier, HapticEnabledAction):
 
 
 class HoldModifier(DoubleclickModifier):
+	__slots__ = ()
 	# Hold modifier is implemented as part of DoubleclickModifier, because
 	# situation when both are assigned to same button needs to be treated
 	# specially.
@@ -1318,6 +1318,7 @@ class SensitivityModifier(Modifier):
 	
 	Does nothing otherwise.
 	"""
+	__slots__ = ( "speeds", )
 	COMMAND = "sens"
 	PROFILE_KEYS = ("sensitivity",)
 	PROFILE_KEY_PRIORITY = -5
@@ -1383,6 +1384,7 @@ class FeedbackModifier(Modifier):
 
 	Does nothing otherwise.
 	"""
+	__slots__ = ( "haptic", )
 	COMMAND = "feedback"
 	PROFILE_KEY_PRIORITY = -4
 	
@@ -1432,6 +1434,7 @@ class FeedbackModifier(Modifier):
 
 class RotateInputModifier(Modifier):
 	""" Rotates ball or stick input along axis """
+	__slots__ = ( "angle", )
 	COMMAND = "rotate"
 	
 	def _mod_init(self, angle):
@@ -1476,6 +1479,8 @@ class SmoothModifier(Modifier):
 	"""
 	Smooths pad movements
 	"""
+	__slots__ = ( "level", "multiplier", "filter", "_deq_x", "_deq_y",
+		"_range", "_weights", "_w_sum", "_last_pos", "_moving" )
 	COMMAND = "smooth"
 	PROFILE_KEY_PRIORITY = 11	# Before sensitivity
 	
@@ -1547,6 +1552,7 @@ class CircularModifier(Modifier, HapticEnabledAction):
 	Designed to translate rotating finger over pad to mouse wheel movement.
 	Can also be used to translate same thing into movement of Axis.
 	"""
+	__slots__ = ( "_haptic_counter", "angle", "speed", "haptic" )
 	COMMAND = "circular"
 	PROFILE_KEY_PRIORITY = -6
 	
@@ -1647,6 +1653,7 @@ class CircularAbsModifier(Modifier, WholeHapticAction):
 	Works similary to CircularModifier, but instead of counting with finger
 	movements movements, translates exact position on dpad to axis value.
 	"""
+	__slots__ = ( "angle", "speed", "haptic", "_ax", "_ay" )
 	COMMAND = "circularabs"
 	PROFILE_KEY_PRIORITY = -6
 	
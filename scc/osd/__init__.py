@@ -38,15 +38,13 @@ class OSDWindow(Gtk.Window):
 	
 	def __init__(self, wmclass):
 		Gtk.Window.__init__(self)
-		OSDWindow._apply_css(Config())
+		OSDWindow._apply_css(Config.get_shared())
 		
-		self.argparser = argparse.ArgumentParser(description=__doc__,
-			formatter_class=argparse.RawDescriptionHelpFormatter,
-			epilog=self.EPILOG)
-		self._add_arguments()
+		self._create_argparser()
 		self.exit_code = -1
 		self.position = (20, -20)
 		self.mainloop = None
+		self.pool = None			# Set by MenuPool if window is kept for reuse
 		self._controller = None
 		self.set_name(wmclass)
 		self.set_wmclass(wmclass, wmclass)
@@ -96,6 +94,13 @@ class OSDWindow(Gtk.Window):
 					Gtk.STYLE_PROVIDER_PRIORITY_USER)
 	
 	
+	def _create_argparser(self):
+		self.argparser = argparse.ArgumentParser(description=__doc__,
+			formatter_class=argparse.RawDescriptionHelpFormatter,
+			epilog=self.EPILOG)
+		self._add_arguments()
+	
+	
 	def _add_arguments(self):
 		""" Should be overriden AND called by child class """
 		self.argparser.add_argument('-x', type=int, metavar="pixels", default=20,
@@ -129,6 +134,9 @@ class OSDWindow(Gtk.Window):
 	
 	def parse_argumets(self, argv):
 		""" Returns True on success """
+		if not hasattr(self, "argparser"):
+			# Window is being reused, see scc.osd.menu_pool
+			self._create_argparser()
 		try:
 			self.args = self.argparser.parse_args(argv[1:])
 		except SystemExit:
@@ -233,6 +241,10 @@ class OSDWindow(Gtk.Window):
 		self.exit_code = code
 		if self.mainloop:
 			self.mainloop.quit()
+		elif self.pool:
+			# Window is owned by MenuPool, it's only hidden to be shown again
+			self.hide()
+			self.pool.window_closed(self)
 		else:
 			self.destroy()
 
@@ -10,11 +10,11 @@ Reuses styles from OSD Menu and OSD Dialog
 from __future__ import unicode_literals
 from scc.tools import _, set_logging_level
 
-from gi.repository import Gtk
+from gi.repository import Gtk, GLib, GdkPixbuf, Rsvg
 from scc.actions import DPadAction, AxisAction, MouseAction
 from scc.actions import Action, MultiAction, XYAction
 from scc.modifiers import ModeModifier, DoubleclickModifier
-from scc.paths import get_share_path, get_config_path
+from scc.paths import get_share_path, get_config_path, get_cache_path
 from scc.menu_data import MenuData, MenuItem
 from scc.lib import xwrappers as X, IntEnum
 from scc.special_actions import MenuAction
@@ -27,24 +27,24 @@ from scc.uinput import Rels
 from scc.gui.svg_widget import SVGWidget, SVGEditor
 from scc.gui.daemon_manager import DaemonManager
 from scc.osd import OSDWindow
-import os, sys, re, base64, logging
+import os, sys, re, base64, hashlib, threading, logging
 log = logging.getLogger("osd.binds")
 
 
 class BindingDisplay(OSDWindow):
 	
 	def __init__(self, config=None):
-		self.bdisplay = os.path.join(get_config_path(), 'binding-display.svg')
-		if not os.path.exists(self.bdisplay):
-			# Prefer image in ~/.config/scc, but load default one as fallback
-			self.bdisplay = os.path.join(get_share_path(), "images", 'binding-display.svg')
+		self.bdisplay = BindingCache.get_default_image()
 		
 		OSDWindow.__init__(self, "osd-keyboard")
 		self.daemon = None
-		self.config = config or Config()
+		self.config = config or Config.get_shared()
 		self.group = None
 		self.limits = {}
 		self.background = None
+		self.cache = None
+		self._profile = None
+		self._rendered = None	# (svg, pixbuf) displayed on background
 		
 		self._eh_ids = []
 		self._stick = 0, 0
@@ -54,8 +54,28 @@ class BindingDisplay(OSDWindow):
 	
 	
 	def on_profile_changed(self, daemon, filename):
-		profile = Profile(TalkingActionParser()).load(filename)
-		Generator(SVGEditor(self.background), profile)
+		if self.cache is None:
+			self.cache = BindingCache(self.args.image, self.config)
+		self._profile = filename
+		controller_type = self.cache.get_controller_type(self.daemon)
+		rendered = self.cache.get(filename, controller_type)
+		if rendered:
+			self.set_rendered(*rendered)
+		else:
+			self.cache.generate_in_background(filename, controller_type,
+				self.on_rendered)
+	
+	
+	def on_rendered(self, filename, controller_type, svg, pixbuf):
+		if filename == self._profile:
+			self.set_rendered(svg, pixbuf)
+	
+	
+	def set_rendered(self, svg, pixbuf):
+		""" Displays image rendered by BindingCache """
+		self._rendered = svg, pixbuf
+		if self.background:
+			self.background.set_prerendered(svg, pixbuf)
 	
 	
 	def use_daemon(self, d):
@@ -90,7 +110,10 @@ class BindingDisplay(OSDWindow):
 				width = geometry.width * 0.8
 				height = int(float(ih) / float(iw) * float(width))
 				self.background.resize(width, height)
-				self.background.hilight({})
+				if self._rendered:
+					self.background.set_prerendered(*self._rendered)
+				else:
+					self.background.hilight({})
 			x = geometry.x + ((geometry.width - width) / 2)
 			y = geometry.y + ((geometry.height - height) / 2)
 		return x, y	
@@ -152,6 +175,8 @@ class BindingDisplay(OSDWindow):
 		if self.background is None:
 			self.realize()
 			self.background = SVGWidget(self.args.image, init_hilighted=True)
+			if self._rendered:
+				self.background.set_prerendered(*self._rendered)
 			self.c.add(self.background)
 			self.add(self.c)
 		
@@ -518,6 +543,149 @@ class Generator(object):
 			b.height = height
 
 
+class BindingCache(object):
+	"""
+	Stores binding display images rendered for profiles in
+	~/.cache/scc/bindings, so displaying bindings doesn't have to wait for
+	layout to be computed and image rendered.
+	
+	Images are keyed by hash of profile file, controller type and style
+	(content of source image and OSD style), so changed profile or style
+	never reuses outdated image.
+	
+	Used by scc-osd-daemon to render image for every newly activated
+	profile in background and by BindingDisplay to load it.
+	"""
+	MAX_IMAGES = 20
+	
+	def __init__(self, image=None, config=None):
+		self.image = image or BindingCache.get_default_image()
+		self.config = config or Config.get_shared()
+		self.path = os.path.join(get_cache_path(), "bindings")
+		self._lock = threading.Lock()
+		self._pending = None	# (filename, controller_type, callback)
+		self._thread = None
+	
+	
+	@staticmethod
+	def get_default_image():
+		image = os.path.join(get_config_path(), 'binding-display.svg')
+		if not os.path.exists(image):
+			# Prefer image in ~/.config/scc, but load default one as fallback
+			image = os.path.join(get_share_path(), "images", 'binding-display.svg')
+		return image
+	
+	
+	@staticmethod
+	def get_controller_type(daemon):
+		"""
+		Returns type of first controller, which is one that 'profile-changed'
+		signal of DaemonManager is emitted for, or None if there is none.
+		"""
+		if daemon and daemon.has_controller():
+			return daemon.get_controllers()[0].get_type()
+		return None
+	
+	
+	def get_key(self, filename, controller_type):
+		h = hashlib.sha1()
+		for f in (filename, self.image):
+			h.update(open(f, "rb").read())
+			h.update(b"\0")
+		h.update(("%s\0%s" % (controller_type, self.config["osd_style"])).encode("utf-8"))
+		return h.hexdigest()
+	
+	
+	def get(self, filename, controller_type):
+		"""
+		Returns (svg, pixbuf) cached for profile or None if there is
+		nothing in cache.
+		"""
+		try:
+			key = self.get_key(filename, controller_type)
+			base = os.path.join(self.path, key)
+			svg = open(base + ".svg", "rb").read().decode("utf-8")
+			pixbuf = GdkPixbuf.Pixbuf.new_from_file(base + ".png")
+			# Touch file so it's not removed as oldest
+			os.utime(base + ".png", None)
+			return svg, pixbuf
+		except Exception:
+			return None
+	
+	
+	def generate(self, filename, controller_type):
+		""" Renders image for profile, stores it in cache and returns (svg, pixbuf) """
+		key = self.get_key(filename, controller_type)
+		profile = Profile(TalkingActionParser()).load(filename)
+		editor = SVGEditor(open(self.image, "rb").read())
+		Generator(editor, profile)
+		svg = editor.to_string()
+		pixbuf = Rsvg.Handle.new_from_data(svg).get_pixbuf()
+		
+		if not os.path.exists(self.path):
+			os.makedirs(self.path)
+		base = os.path.join(self.path, key)
+		# Both files are written under temporary name and renamed, so
+		# other process never sees half-written image
+		pixbuf.savev(base + ".png.tmp", "png", [], [])
+		file(base + ".svg.tmp", "wb").write(svg)
+		os.rename(base + ".svg.tmp", base + ".svg")
+		os.rename(base + ".png.tmp", base + ".png")
+		self._cleanup()
+		return svg.decode("utf-8"), pixbuf
+	
+	
+	def _cleanup(self):
+		""" Removes oldest images so there is at most MAX_IMAGES stored """
+		images = [ os.path.join(self.path, x) for x in os.listdir(self.path)
+			if x.endswith(".png") ]
+		if len(images) <= self.MAX_IMAGES:
+			return
+		images.sort(key = os.path.getmtime)
+		for png in images[0:-self.MAX_IMAGES]:
+			for f in (png, png[0:-4] + ".svg"):
+				try:
+					os.unlink(f)
+				except OSError:
+					pass
+	
+	
+	def generate_in_background(self, filename, controller_type, callback=None):
+		"""
+		Renders and stores image in worker thread, unless it's already
+		cached. If callback is set, it's called in main thread as
+		callback(filename, controller_type, svg, pixbuf) once done.
+		
+		If called again while previous image is being rendered, only most
+		recent request is processed after that.
+		"""
+		with self._lock:
+			self._pending = filename, controller_type, callback
+			if self._thread is None:
+				self._thread = threading.Thread(target=self._worker)
+				self._thread.daemon = True
+				self._thread.start()
+	
+	
+	def _worker(self):
+		while True:
+			with self._lock:
+				if self._pending is None:
+					self._thread = None
+					return
+				filename, controller_type, callback = self._pending
+				self._pending = None
+			try:
+				rendered = self.get(filename, controller_type)
+				if rendered is None:
+					log.debug("Rendering bindings of %s", filename)
+					rendered = self.generate(filename, controller_type)
+			except Exception, e:
+				log.warning("Failed to render bindings of %s: %s", filename, e)
+				continue
+			if callback:
+				GLib.idle_add(callback, filename, controller_type, *rendered)
+
 
 def main():
 	m = BindingDisplay()
@@ -122,7 +122,7 @@ class Dialog(OSDWindow):
 		if not OSDWindow.parse_argumets(self, argv):
 			return False
 		if not self.config:
-			self.config = Config()
+			self.config = Config.get_shared()
 		
 		try:
 			self.items = MenuData.from_args(self.args.items)
@@ -152,6 +152,36 @@ class Dialog(OSDWindow):
 		return True
 	
 	
+	def reuse(self, argv):
+		"""
+		Prepares already built dialog, kept by MenuPool, to be displayed again.
+		Dialog text and item labels have to be same as when dialog was built,
+		only item IDs are taken from argv.
+		
+		Returns True on success.
+		"""
+		if not OSDWindow.parse_argumets(self, argv):
+			return False
+		try:
+			items = MenuData.from_args(self.args.items)
+		except ValueError:
+			return False
+		if len(items) != len(self.items):
+			return False
+		for item, new_item in zip(self.items, items):
+			item.id = new_item.id
+		if self._selected:
+			self._selected.widget.set_name(self._selected.widget.get_name()
+				.replace("-selected", ""))
+		self._selected = None
+		self.exit_code = -1
+		self.feedback = None
+		self.controller = None
+		if self.args.feedback_amplitude:
+			self.feedback = "LEFT", int(self.args.feedback_amplitude)
+		return True
+	
+	
 	def generate_widget(self, item):
 		""" Generates gtk widget for specified menutitem """
 		widget = Gtk.Button.new_with_label(item.label)
@@ -215,7 +245,7 @@ class Dialog(OSDWindow):
 			log.error("Sucessfully locked input")
 		
 		if not self.config:
-			self.config = Config()
+			self.config = Config.get_shared()
 		self.controller = self.choose_controller(self.daemon)
 		if self.controller is None or not self.controller.is_connected():
 			# There is no controller connected to daemon
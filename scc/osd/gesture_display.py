@@ -53,7 +53,7 @@ class GestureDisplay(OSDWindow):
 		self._gesture = None
 		
 		self.setup_widgets()
-		self.use_config(config or Config())
+		self.use_config(config or Config.get_shared())
 	
 	
 	def setup_widgets(self):
@@ -103,7 +103,7 @@ class GestureDisplay(OSDWindow):
 		if not OSDWindow.parse_argumets(self, argv):
 			return False
 		if not self.config:
-			self.use_config(Config())
+			self.use_config(Config.get_shared())
 		
 		# Parse simpler arguments
 		self._control_with = self.args.control_with
@@ -136,7 +136,7 @@ class GestureDisplay(OSDWindow):
 			# self._right_detector.enable()
 		
 		if not self.config:
-			self.config = Config()
+			self.config = Config.get_shared()
 		locks = [ self._control_with ]
 		c = self.choose_controller(self.daemon)
 		if c is None or not c.is_connected():
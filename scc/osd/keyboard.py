@@ -313,7 +313,7 @@ class Keyboard(OSDWindow, TimerManager):
 		self.keymap.connect('state-changed', self.on_keymap_state_changed)
 		Action.register_all(sys.modules['scc.osd.osk_actions'], prefix="OSK")
 		self.profile = Profile(TalkingActionParser())
-		self.config = config or Config()
+		self.config = config or Config.get_shared()
 		self.dpy = X.Display(hash(GdkX11.x11_get_default_xdisplay()))
 		self.group = None
 		self.limits = {}
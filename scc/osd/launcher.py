@@ -213,7 +213,7 @@ class Launcher(OSDWindow):
 		if not OSDWindow.parse_argumets(self, argv):
 			return False
 		if not self.config:
-			self.config = Config()
+			self.config = Config.get_shared()
 		
 		if self.args.feedback_amplitude:
 			side = "LEFT"
@@ -343,7 +343,7 @@ class Launcher(OSDWindow):
 			log.error("Sucessfully locked input")
 		
 		if not self.config:
-			self.config = Config()
+			self.config = Config.get_shared()
 		self.controller = self.choose_controller(self.daemon)
 		if self.controller is None or not self.controller.is_connected():
 			# There is no controller connected to daemon
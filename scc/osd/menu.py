@@ -207,7 +207,7 @@ class Menu(OSDWindow):
 		if not self.parse_menu():
 			return False
 		if not self.config:
-			self.config = Config()
+			self.config = Config.get_shared()
 		
 		# Parse simpler arguments
 		self._size = self.args.size
@@ -232,6 +232,34 @@ class Menu(OSDWindow):
 		return True
 	
 	
+	def reuse(self, argv):
+		"""
+		Prepares already built menu, kept by MenuPool, to be displayed again.
+		Only arguments that don't change menu content (position, controls
+		and similar) are taken from argv, items and widgets are kept.
+		
+		Returns True on success.
+		"""
+		if not OSDWindow.parse_argumets(self, argv):
+			return False
+		self.reset()
+		return True
+	
+	
+	def reset(self):
+		""" Resets state left from previous time menu was displayed """
+		if self._selected:
+			self._selected.widget.set_name(self._selected.widget.get_name()
+				.replace("-selected", ""))
+		self._selected = None
+		self._submenu = None
+		self.exit_code = -1
+		self.feedback = None
+		self.controller = None
+		self._control_with_dpad = False
+		self.disable_cursor()
+	
+	
 	def enable_cursor(self):
 		if not self._use_cursor:
 			self.f.add(self.cursor)
@@ -239,6 +267,12 @@ class Menu(OSDWindow):
 			self._use_cursor = True
 	
 	
+	def disable_cursor(self):
+		if self._use_cursor:
+			self.f.remove(self.cursor)
+			self._use_cursor = False
+	
+	
 	def generate_widget(self, item):
 		""" Generates gtk widget for specified menutitem """
 		if isinstance(item, Separator) and item.label:
@@ -365,7 +399,7 @@ class Menu(OSDWindow):
 	
 	def on_daemon_connected(self, *a):
 		if not self.config:
-			self.config = Config()
+			self.config = Config.get_shared()
 		self.controller = self.choose_controller(self.daemon)
 		if self.controller is None or not self.controller.is_connected():
 			# There is no controller connected to daemon
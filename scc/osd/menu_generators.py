@@ -9,8 +9,8 @@ from scc.tools import _, set_logging_level
 
 from gi.repository import Gdk, Gio, GdkX11
 from scc.menu_data import MenuGenerator, MenuItem, MENU_GENERATORS
-from scc.paths import get_profiles_path, get_default_profiles_path
-from scc.tools import find_profile
+from scc.tools import find_profile, get_profile_list
+from scc.game_index import GameIndex
 from scc.lib import xwrappers as X
 
 from ctypes import POINTER, cast
@@ -37,16 +37,10 @@ class ProfileListMenuGenerator(MenuGenerator):
 	
 	
 	def generate(self, menuhandler):
-		# TODO: Cannot load directory content asynchronously here and I'm
-		# TODO: not happy about it
-		rv, all_profiles = [], {}
-		for d in (get_default_profiles_path(), get_profiles_path()):
-			for x in os.listdir(d):
-				if x.endswith(".sccprofile") and not x.startswith("."):
-					all_profiles[x] = os.path.join(d, x)
+		rv, all_profiles = [], get_profile_list()
 		for p in sorted(all_profiles, key=lambda s: s.lower()):
-			menuitem = MenuItem("generated", p[0:-11])	# strips ".sccprofile"
-			menuitem.filename = all_profiles[p]
+			menuitem = MenuItem("generated", p)
+			menuitem.filename, is_override, mtime = all_profiles[p]
 			menuitem.callback = self.callback
 			rv.append(menuitem)
 		return rv
@@ -144,10 +138,11 @@ class GameListMenuGenerator(MenuGenerator):
 	MAX_LENGHT = 50
 	
 	_games = None		# Static list of know games
+	_games_mtime = None	# mtime of cache file games were loaded from
 	
 	def generate(self, menuhandler):
 		return _("[ Games ]")
-
+	
 	
 	def encode(self):
 		return { "generator" : self.GENERATOR_NAME }
@@ -155,11 +150,44 @@ class GameListMenuGenerator(MenuGenerator):
 	
 	@staticmethod
 	def callback(menu, daemon, controller, menuitem):
-		menuitem._desktop_file.launch()
+		if menuitem._desktop_file is None:
+			menuitem._desktop_file = Gio.DesktopAppInfo.new_from_filename(
+				menuitem.filename)
+		if menuitem._desktop_file:
+			menuitem._desktop_file.launch([], None)
 		menu.quit(-2)
 	
 	
+	@staticmethod
+	def _icon(name):
+		if not name:
+			return None
+		if os.path.isabs(name):
+			return Gio.FileIcon.new(Gio.File.new_for_path(name))
+		return Gio.ThemedIcon.new(name)
+	
+	
 	def generate(self, menuhandler):
+		# List of games is maintained by scc-daemon (see scc.game_index)
+		# and read from cache file. Only if that file is not available,
+		# all installed applications are enumerated.
+		filename = GameIndex.get_cache_file()
+		try:
+			mtime = os.stat(filename).st_mtime
+		except OSError:
+			mtime = None
+		if mtime is not None and mtime != GameListMenuGenerator._games_mtime:
+			games = GameIndex.read_games(filename)
+			if games is not None:
+				GameListMenuGenerator._games_mtime = mtime
+				GameListMenuGenerator._games = []
+				for id, game in enumerate(games):
+					menuitem = MenuItem(str(id), game["name"][0:self.MAX_LENGHT],
+						icon = GameListMenuGenerator._icon(game["icon"]))
+					menuitem.callback = GameListMenuGenerator.callback
+					menuitem.filename = game["filename"]
+					menuitem._desktop_file = None
+					GameListMenuGenerator._games.append(menuitem)
 		if GameListMenuGenerator._games is None:
 			GameListMenuGenerator._games = []
 			id = 0
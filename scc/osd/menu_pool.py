@@ -0,0 +1,267 @@
+#!/usr/bin/env python2
+"""
+SC-Controller - OSD Menu Pool
+
+Keeps pre-built, hidden menu windows for menus referenced by active profile,
+so scc-osd-daemon can display them without parsing menu file, resolving
+icons and packing widgets on every button press.
+
+Window is rebuilt only when file it was built from (menu or profile) is
+changed or when OSD style changes.
+"""
+from __future__ import unicode_literals
+
+from gi.repository import GLib
+from scc.special_actions import MenuAction, QuickMenuAction, DialogAction
+from scc.menu_data import MenuData, MenuGenerator
+from scc.osd.radial_menu import RadialMenu
+from scc.osd.hmenu import HorizontalMenu
+from scc.osd.quick_menu import QuickMenu
+from scc.osd.grid_menu import GridMenu
+from scc.osd.dialog import Dialog
+from scc.osd.menu import Menu
+from scc.parser import ActionParser
+from scc.profile import Profile
+from scc.actions import Action
+from scc.tools import find_menu
+
+import os, logging
+log = logging.getLogger("osd.pool")
+
+
+class MenuPool(object):
+	WINDOW_CLASSES = {
+		"menu"			: Menu,
+		"hmenu"			: HorizontalMenu,
+		"radialmenu"	: RadialMenu,
+		"quickmenu"		: QuickMenu,
+		"gridmenu"		: GridMenu,
+		"dialog"		: Dialog,
+	}
+	
+	# Arguments that don't change content of menu and so may differ between
+	# two requests served by same window, mapped to number of their parameters
+	VOLATILE_ARGS = {
+		"-x" : 1, "-y" : 1, "--controller" : 1,
+		"--control-with" : 1, "-c" : 1,
+		"--confirm-with" : 1, "--cancel-with" : 1,
+		"--feedback-amplitude" : 1, "--rotation" : 1, "--timeout" : 1,
+		"--use-cursor" : 0, "-u" : 0, "-d" : 0,
+		"--confirm-with-release" : 0, "--cancel-with-release" : 0,
+	}
+	# Arguments that do change content of menu and take parameter
+	CONTENT_ARGS = ( "--from-profile", "-p", "--from-file", "-f",
+		"--size", "--text" )
+	
+	def __init__(self, config, on_closed):
+		"""
+		on_closed is called as on_closed(window) every time when pooled
+		window is closed (hidden), same way as 'destroy' signal is used
+		with windows that are not pooled.
+		"""
+		self.config = config
+		self.on_closed = on_closed
+		self._windows = {}		# key -> (window, mtime)
+		self._wanted = {}		# key -> argv used to build window
+		self._in_use = set()
+		self._orphaned = set()	# Discarded while displayed
+		self._prewarm_id = None
+	
+	
+	@staticmethod
+	def get_key(argv):
+		"""
+		Returns hashable key identifying content of menu requested by
+		argument list received from scc-daemon.
+		argv[0] is menu type.
+		"""
+		key, positional, i = [ argv[0] ], [], 1
+		while i < len(argv):
+			arg = argv[i]
+			if arg in MenuPool.VOLATILE_ARGS:
+				i += MenuPool.VOLATILE_ARGS[arg]
+			elif arg in MenuPool.CONTENT_ARGS:
+				value = argv[i + 1] if i + 1 < len(argv) else None
+				if arg != "--size" or value not in ("0", None):
+					key += [ arg, value ]
+				i += 1
+			elif arg.startswith("-"):
+				key.append(arg)
+			else:
+				positional.append(arg)
+			i += 1
+		if argv[0] == "dialog":
+			# Dialog items are sent as 'id label' pairs where IDs are
+			# generated by scc-daemon and only labels are interesting
+			positional = positional[1::2]
+		return tuple(key + positional)
+	
+	
+	@staticmethod
+	def get_source_file(argv):
+		""" Returns file that menu is loaded from or None """
+		for i in xrange(1, len(argv) - 1):
+			if argv[i] in ("--from-profile", "-p", "--from-file", "-f"):
+				return argv[i + 1]
+		return None
+	
+	
+	@staticmethod
+	def _get_mtime(filename):
+		if filename is None:
+			return None
+		try:
+			return os.stat(filename).st_mtime
+		except OSError:
+			return None
+	
+	
+	def get(self, argv):
+		"""
+		Returns window prepared to be displayed for request described by
+		argv (list of arguments received from scc-daemon) or None if
+		request can't be served from pool.
+		"""
+		key = self.get_key(argv)
+		if key not in self._wanted or key[0] not in self.WINDOW_CLASSES:
+			return None
+		mtime = self._get_mtime(self.get_source_file(argv))
+		if key in self._windows:
+			window, built_mtime = self._windows[key]
+			if window in self._in_use:
+				return None
+			if built_mtime != mtime:
+				log.debug("Rebuilding %s: source file changed", key[0])
+				self._discard(key)
+		if key not in self._windows:
+			if not self._build(key, argv):
+				return None
+		window, trash = self._windows[key]
+		if not window.reuse(argv):
+			return None
+		self._in_use.add(window)
+		return window
+	
+	
+	def window_closed(self, window):
+		""" Called by OSDWindow.quit on pooled window """
+		if window in self._in_use:
+			self._in_use.remove(window)
+			self.on_closed(window)
+		if window in self._orphaned:
+			self._orphaned.remove(window)
+			window.pool = None
+			window.destroy()
+	
+	
+	def clear(self):
+		"""
+		Destroys all pooled windows. Called when OSD style changes.
+		Windows are rebuilt in background.
+		"""
+		for key in list(self._windows):
+			self._discard(key)
+		self._schedule_prewarm()
+	
+	
+	def set_profile(self, filename):
+		"""
+		Loads profile and determines which menus it uses.
+		Windows for those menus are then built in background, windows
+		for menus that are no longer needed are destroyed.
+		"""
+		wanted = {}
+		try:
+			profile = Profile(ActionParser()).load(filename)
+			for action in profile.get_all_actions():
+				argv = self._get_argv(profile, action)
+				if argv:
+					wanted[self.get_key(argv)] = argv
+		except Exception, e:
+			log.warning("Failed to load menus used by '%s': %s", filename, e)
+		self._wanted = wanted
+		for key in list(self._windows):
+			if key not in self._wanted:
+				self._discard(key)
+		self._schedule_prewarm()
+	
+	
+	def _get_argv(self, profile, action):
+		"""
+		Returns argument list as scc-daemon would send it when action is
+		executed, minus volatile parameters, or None if action doesn't
+		display menu or menu can't be pooled.
+		"""
+		if isinstance(action, MenuAction):
+			argv = [ action.MENU_TYPE ]
+			if "." in action.menu_id:
+				path = find_menu(action.menu_id)
+				if not path:
+					return None
+				argv += [ "--from-file", path ]
+				data = MenuData.from_file(path)
+			else:
+				if action.menu_id not in profile.menus:
+					return None
+				argv += [ "--from-profile", profile.get_filename(), action.menu_id ]
+				data = profile.menus[action.menu_id]
+			for item in data:
+				if isinstance(item, MenuGenerator):
+					# Generated menus may change every time they are displayed
+					return None
+			if action.size and not isinstance(action, QuickMenuAction):
+				argv += [ "--size", str(action.size) ]
+			return argv
+		if isinstance(action, DialogAction):
+			argv = [ "dialog", "--text", action.text ]
+			for i in xrange(len(action.options)):
+				argv += [ str(i), action.options[i].describe(Action.AC_MENU) ]
+			return argv
+		return None
+	
+	
+	def _build(self, key, argv):
+		""" Builds new window and stores it in pool. Returns True on success """
+		window = self.WINDOW_CLASSES[key[0]]()
+		window.use_config(self.config)
+		try:
+			if not window.parse_argumets(argv):
+				window.destroy()
+				return False
+		except Exception, e:
+			log.exception(e)
+			window.destroy()
+			return False
+		window.pool = self
+		mtime = self._get_mtime(self.get_source_file(argv))
+		self._windows[key] = window, mtime
+		return True
+	
+	
+	def _discard(self, key):
+		window, trash = self._windows.pop(key)
+		if window in self._in_use:
+			# Currently displayed, destroyed once closed
+			self._orphaned.add(window)
+		else:
+			window.destroy()
+	
+	
+	def _schedule_prewarm(self):
+		if self._prewarm_id is None:
+			self._prewarm_id = GLib.idle_add(self._prewarm)
+	
+	
+	def _prewarm(self):
+		"""
+		Builds one missing window on every call.
+		Returns True while there is something left to build.
+		"""
+		for key in self._wanted:
+			if key not in self._windows:
+				if not self._build(key, self._wanted[key]):
+					# Don't try to build it again
+					del self._wanted[key]
+				return True
+		self._prewarm_id = None
+		return False
@@ -136,7 +136,7 @@ class QuickMenu(Menu):
 			print "failed to parse menu"
 			return False
 		if not self.config:
-			self.config = Config()
+			self.config = Config.get_shared()
 		
 		self._cancel_with = self.args.cancel_with
 		self._timeout = self.args.timeout
@@ -157,6 +157,25 @@ class QuickMenu(Menu):
 		return True
 	
 	
+	def reuse(self, argv):
+		if not Menu.reuse(self, argv):
+			return False
+		self._cancel_with = self.args.cancel_with
+		self._timeout = self.args.timeout
+		return True
+	
+	
+	def reset(self):
+		self.cancel_timer()
+		for item in self._pressed:
+			item.widget.set_name("osd-menu-item")
+		self._pressed = []
+		self._selected = None
+		self._submenu = None
+		self.exit_code = -1
+		self.controller = None
+	
+	
 	def next_item(self, direction):
 		pass
 	
@@ -13,7 +13,7 @@ from scc.menu_data import MenuData, Separator, Submenu
 from scc.gui.svg_widget import SVGWidget, SVGEditor
 from scc.osd.menu import Menu, MenuIcon
 from scc.osd import OSDWindow
-from scc.tools import degdiff, find_icon
+from scc.tools import find_icon
 from scc.paths import get_share_path
 from scc.lib import xwrappers as X
 from scc.config import Config
@@ -35,18 +35,28 @@ class RadialMenu(Menu):
 		self.rotation = 0
 		self.scale = 1.0
 		self.items_with_icon = []
+		# Sector geometry, computed once in pack_items
+		self._sector_size = 360.0
+		self._center = 0, 0
+		self._radius = 0
+		self._offset = 0, 0
+		# Cairo surfaces with whole menu rendered without and with
+		# every item hilighted. Selected sector is painted from latter.
+		self._background = None
+		self._hilighted = None
 	
 	
 	def create_parent(self):
 		background = os.path.join(get_share_path(), "images", 'radial-menu.svg')
 		self.b = SVGWidget(background)
 		self.b.connect('size-allocate', self.on_size_allocate)
+		self.b.image.connect('draw', self.on_image_draw)
 		self.recolor()
 		return self.b
 	
 	
 	def recolor(self):
-		config = Config()
+		config = Config.get_shared()
 		source_colors = {}
 		try:
 			# Try to read json file and bail out if it fails
@@ -73,6 +83,13 @@ class RadialMenu(Menu):
 	
 	def on_size_allocate(self, trash, allocation):
 		""" (Re)centers all icons when menu is displayed or size is changed """
+		if self._background:
+			# Gtk.Image centers image in its allocation
+			image = self.b.image.get_allocation()
+			self._offset = (
+				int((image.width - self._background.get_width()) * 0.5),
+				int((image.height - self._background.get_height()) * 0.5)
+			)
 		cx = allocation.width * self.scale * 0.5
 		cy = allocation.height * self.scale * 0.5
 		radius = min(cx, cy) * 2 / 3
@@ -107,6 +124,27 @@ class RadialMenu(Menu):
 		return rv
 	
 	
+	def reuse(self, argv):
+		if not Menu.reuse(self, argv):
+			return False
+		self.rotation = self.args.rotation
+		self.enable_cursor()
+		return True
+	
+	
+	def reset(self):
+		if self._selected and hasattr(self._selected, "icon_widget"):
+			if self._selected.icon_widget:
+				self._selected.icon_widget.set_name("osd-radial-menu-icon")
+		if self._selected:
+			self._queue_sector_draw(self._selected)
+		self._selected = None
+		self._submenu = None
+		self.exit_code = -1
+		self.feedback = None
+		self.controller = None
+	
+	
 	def generate_widget(self, item):
 		if isinstance(item, (Separator, Submenu)) or item.id is None:
 			# Labels and separators, radial menu can't show these
@@ -189,6 +227,76 @@ class RadialMenu(Menu):
 		self.editor.remove_element("menuitem_template")
 		self.editor.commit()
 		del self.editor
+		self._sector_size = 360.0 / max(1, len(self.items))
+		self._prepare_surfaces(items)
+	
+	
+	def _prepare_surfaces(self, items):
+		"""
+		Renders menu without and with all items hilighted and stores both
+		images as cairo surfaces, so changing selection only repaints
+		two sectors instead of recoloring and rendering whole SVG.
+		"""
+		hilight = {}
+		for i in items:
+			hilight["menuitem_" + i.id] = "#" + self.config["osd_colors"]["menuitem_hilight"]
+			hilight["text_" + i.id] = "#" + self.config["osd_colors"]["menuitem_hilight_text"]
+		self.b.hilight(hilight)
+		pb = self.b.get_pixbuf()
+		self._hilighted = Gdk.cairo_surface_create_from_pixbuf(pb, 1, None)
+		self.b.hilight({})
+		pb = self.b.get_pixbuf()
+		self._background = Gdk.cairo_surface_create_from_pixbuf(pb, 1, None)
+		self._center = pb.get_width() * self.scale * 0.5, pb.get_height() * self.scale * 0.5
+		self._radius = min(*self._center)
+	
+	
+	def _sector_path(self, cr, item):
+		""" Adds path of sector occupied by item to cairo context """
+		cx, cy = self._center
+		half = self._sector_size * 0.5
+		cr.move_to(cx, cy)
+		cr.arc(cx, cy, self._radius,
+			(item.a - 90.0 - half) * PI / 180.0,
+			(item.a - 90.0 + half) * PI / 180.0)
+		cr.close_path()
+	
+	
+	def _queue_sector_draw(self, item):
+		""" Invalidates bounding box of sector occupied by item """
+		if self._background is None:
+			return
+		cx, cy = self._center
+		half = self._sector_size * 0.5
+		xs, ys = [ cx ], [ cy ]
+		# Sector is bounded by center, both ends of arc and by every
+		# axis-aligned extreme of circle that lies on arc
+		a, end = item.a - half, item.a + half
+		while True:
+			xs.append(cx + sin(a * PI / 180.0) * self._radius)
+			ys.append(cy - cos(a * PI / 180.0) * self._radius)
+			if a >= end:
+				break
+			a = min(end, (a // 90.0 + 1) * 90.0)
+		x, y = int(min(xs)) - 1 + self._offset[0], int(min(ys)) - 1 + self._offset[1]
+		self.b.image.queue_draw_area(x, y,
+			int(max(xs)) + 2 + self._offset[0] - x,
+			int(max(ys)) + 2 + self._offset[1] - y)
+	
+	
+	def on_image_draw(self, image, cr):
+		if self._background is None:
+			# Not packed yet, let Gtk.Image draw itself
+			return False
+		cr.translate(*self._offset)
+		cr.set_source_surface(self._background, 0, 0)
+		cr.paint()
+		if self._selected:
+			self._sector_path(cr, self._selected)
+			cr.clip()
+			cr.set_source_surface(self._hilighted, 0, 0)
+			cr.paint()
+		return True
 	
 	
 	def show(self):
@@ -230,13 +338,12 @@ class RadialMenu(Menu):
 		if self._selected and hasattr(self._selected, "icon_widget"):
 			if self._selected.icon_widget:
 				self._selected.icon_widget.set_name("osd-radial-menu-icon")
+		if self._selected:
+			self._queue_sector_draw(self._selected)
 		self._selected = i
 		if hasattr(self._selected, "icon_widget") and self._selected.icon_widget:
 			self._selected.icon_widget.set_name("osd-radial-menu-icon-selected")
-		self.b.hilight({
-			"menuitem_" + i.id : "#" + self.config["osd_colors"]["menuitem_hilight"],
-			"text_" + i.id :  "#" + self.config["osd_colors"]["menuitem_hilight_text"],
-		})
+		self._queue_sector_draw(i)
 	
 	
 	def on_event(self, daemon, what, data):
@@ -264,14 +371,13 @@ class RadialMenu(Menu):
 			self.f.move(self.cursor, int(cx), int(cy))
 			
 			if abs(x) + abs(y) > RadialMenu.MIN_DISTANCE:
-				angle = atan2(x, y) * 180.0 / PI
-				half_width = 180.0 / len(self.items)
-				for i in self.items:
-					if abs(degdiff(i.a, angle)) < half_width:
-						if self._selected != i:
-							if self.feedback and self.controller:
-								self.controller.feedback(*self.feedback)
-							self.select(i)
+				# Item N is centered at angle N * sector_size
+				angle = atan2(x, y) * 180.0 / PI + self._sector_size * 0.5
+				i = self.items[int((angle % 360.0) / self._sector_size) % len(self.items)]
+				if self._selected != i:
+					if self.feedback and self.controller:
+						self.controller.feedback(*self.feedback)
+					self.select(i)
 		else:
 			return Menu.on_event(self, daemon, what, data)
 
@@ -18,7 +18,7 @@ from scc.tools import nameof
 import scc.aliases
 
 import token as TokenType
-import sys
+import sys, threading
 
 
 class ParseError(Exception): pass
@@ -63,6 +63,8 @@ class ActionParser(object):
 	
 	
 	def __init__(self, string=""):
+		# Held while parsing actions of lazily loaded profile, see scc.profile
+		self.lock = threading.RLock()
 		self.restart(string)
 	
 	
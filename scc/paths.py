@@ -24,6 +24,19 @@ def get_config_path():
 	return os.path.join(confdir, "scc")
 
 
+def get_cache_path():
+	"""
+	Returns directory where cached data are stored.
+	~/.cache/scc under normal conditions.
+	
+	This directory may not exist.
+	"""
+	cachedir = os.path.expanduser("~/.cache")
+	if "XDG_CACHE_HOME" in os.environ:
+		cachedir = os.environ['XDG_CACHE_HOME']
+	return os.path.join(cachedir, "scc")
+
+
 def get_profiles_path():
 	"""
 	Returns directory where profiles are stored.
@@ -108,14 +121,20 @@ def get_default_controller_icons_path():
 	return os.path.join(get_share_path(), "images", "controller-icons")
 
 
+_share_path = None
+
 def get_share_path():
 	"""
 	Returns directory where shared files are kept.
 	Usually "/usr/share/scc" or $SCC_SHARED if program is being started from
 	script extracted from source tarball
 	"""
+	global _share_path
 	if "SCC_SHARED" in os.environ:
 		return os.environ["SCC_SHARED"]
+	if _share_path is not None:
+		# Found already, installation is not expected to move
+		return _share_path
 	paths = (
 		"/usr/local/share/scc/",
 		os.path.expanduser("~/.local/share/scc"),
@@ -123,6 +142,7 @@ def get_share_path():
 	)
 	for path in paths:
 		if os.path.exists(path):
+			_share_path = path
 			return path
 	# No path found, assume default and hope for best
 	return "/usr/share/scc"
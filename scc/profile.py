@@ -9,13 +9,13 @@ from __future__ import unicode_literals
 from scc.constants import LEFT, RIGHT, CPAD, DPAD, WHOLE, STICK, RSTICK, GYRO
 from scc.constants import SCButtons, HapticPos
 from scc.special_actions import MenuAction
-from scc.modifiers import HoldModifier
+from scc.modifiers import HoldModifier, ModeModifier
 from scc.lib.jsonencoder import JSONEncoder
 from scc.parser import TalkingActionParser
 from scc.menu_data import MenuData
 from scc.actions import NoAction
 
-import json, logging
+import os, json, logging
 log = logging.getLogger("profile")
 
 
@@ -43,6 +43,7 @@ class Profile(object):
 		self.parser = parser
 		self.clear()
 		self.filename = None
+		self.mtime = None
 		# UI-only values
 		self.is_template = False
 		self.description = ""
@@ -86,19 +87,24 @@ class Profile(object):
 		return self
 	
 	
-	def load(self, filename):
+	def load(self, filename, lazy=False):
 		""" Loads profile from file. Returns self """
 		fileobj = open(filename, "r")
-		self.load_fileobj(fileobj)
+		mtime = os.fstat(fileobj.fileno()).st_mtime
+		self.load_fileobj(fileobj, lazy)
 		self.filename = filename
+		self.mtime = mtime
 		return self
 	
 	
-	def load_fileobj(self, fileobj):
+	def load_fileobj(self, fileobj, lazy=False):
 		"""
 		Loads profile from file-like object.
 		Filename attribute is not set, what may cause some trouble if used in GUI.
 		
+		If 'lazy' is True, actions and menus are stored as LazyAction and
+		LazyMenu instances and parsed only when they are used for first time.
+		
 		Returns self.
 		"""
 		data = json.loads(fileobj.read())
@@ -119,55 +125,53 @@ class Profile(object):
 		# Settings - Template
 		self.is_template = bool(data["is_template"]) if "is_template" in data else False
 		
+		# Actions are parsed only when needed if requested and if profile
+		# doesn't need conversion
+		lazy = lazy and version >= Profile.VERSION
+		self.signatures = {}
+		
 		# Buttons
 		self.buttons = {}
 		for x in SCButtons:
-			self.buttons[x] = self.parser.from_json_data(data["buttons"], x.name)
+			self._load_action(data["buttons"], x.name, "buttons", x, lazy)
 		# Pressing stick is interpreted as STICKPRESS button,
 		# formely called just STICK
 		if "STICK" in data["buttons"] and "STICKPRESS" not in data["buttons"]:
-			self.buttons[SCButtons.STICKPRESS] = self.parser.from_json_data(
-					data["buttons"], "STICK")
+			self._load_action(data["buttons"], "STICK", "buttons", SCButtons.STICKPRESS, lazy)
 		
 		# Stick & gyro
-		self.stick = self.parser.from_json_data(data, "stick")
-		self.gyro = self.parser.from_json_data(data, "gyro")
+		self._load_action(data, "stick", "stick", None, lazy)
+		self._load_action(data, "gyro", "gyro", None, lazy)
 		
+		self.triggers, self.pads = {}, {}
 		if "triggers" in data:
 			# Old format
 			# Triggers
-			self.triggers = ({
-				x : self.parser.from_json_data(data["triggers"], x) for x in Profile.TRIGGERS
-			})
+			for x in Profile.TRIGGERS:
+				self._load_action(data["triggers"], x, "triggers", x, lazy)
 			
 			# Pads
-			self.pads = {
-				Profile.LEFT	: self.parser.from_json_data(data, "left_pad"),
-				Profile.RIGHT	: self.parser.from_json_data(data, "right_pad"),
-				Profile.CPAD	: NoAction(),
-				Profile.DPAD	: NoAction(),
-			}
+			self._load_action(data, "left_pad", "pads", Profile.LEFT, lazy)
+			self._load_action(data, "right_pad", "pads", Profile.RIGHT, lazy)
+			self.pads[Profile.CPAD] = NoAction()
+			self.pads[Profile.DPAD] = NoAction()
 			
 			# Rigth stick
 			self.rstick = NoAction()
 		else:
 			# New format
 			# Triggers
-			self.triggers = {
-				Profile.LEFT	: self.parser.from_json_data(data, "trigger_left"),
-				Profile.RIGHT	: self.parser.from_json_data(data, "trigger_right"),
-			}
+			self._load_action(data, "trigger_left", "triggers", Profile.LEFT, lazy)
+			self._load_action(data, "trigger_right", "triggers", Profile.RIGHT, lazy)
 			
 			# Pads
-			self.pads = {
-				Profile.LEFT	: self.parser.from_json_data(data, "pad_left"),
-				Profile.RIGHT	: self.parser.from_json_data(data, "pad_right"),
-				Profile.CPAD	: self.parser.from_json_data(data, "cpad"),
-				Profile.DPAD	: self.parser.from_json_data(data, "dpad"),
-			}
+			self._load_action(data, "pad_left", "pads", Profile.LEFT, lazy)
+			self._load_action(data, "pad_right", "pads", Profile.RIGHT, lazy)
+			self._load_action(data, "cpad", "pads", Profile.CPAD, lazy)
+			self._load_action(data, "dpad", "pads", Profile.DPAD, lazy)
 			
 			# Rigth stick
-			self.rstick = self.parser.from_json_data(data, "rstick")
+			self._load_action(data, "rstick", "rstick", None, lazy)
 		
 		# Menus
 		self.menus = {}
@@ -176,16 +180,56 @@ class Profile(object):
 				for invalid_char in ".:/":
 					if invalid_char in id:
 						raise ValueError("Invalid character '%s' in menu id '%s'" % (invalid_char, id))
-				self.menus[id] = MenuData.from_json_data(data["menus"][id], self.parser)
+				if lazy:
+					self.menus[id] = LazyMenu(self.parser, data["menus"][id], self.menus, id)
+				else:
+					self.menus[id] = MenuData.from_json_data(data["menus"][id], self.parser)
 		
 		# Conversion
 		self.original_version = version		# TODO: This is temporary
 		if version < Profile.VERSION:
 			self._convert(version)
+			# Signatures are generated from converted actions in compress()
+			self.signatures = {}
 		
 		return self
 	
 	
+	def _load_action(self, data, key, name, ckey, lazy):
+		"""
+		Parses action stored in data[key] and stores it as self.name[ckey],
+		or as self.name if ckey is None. Records signature of action as well.
+		"""
+		if ckey is None:
+			container, ckey, sigkey = self, name, name
+		else:
+			container, sigkey = getattr(self, name), (name, ckey)
+		self.signatures[sigkey] = json.dumps(data.get(key), sort_keys=True)
+		if lazy and key in data:
+			a = LazyAction(self.parser, data[key], container, ckey)
+		else:
+			a = self.parser.from_json_data(data, key)
+		if container is self:
+			setattr(self, ckey, a)
+		else:
+			container[ckey] = a
+	
+	
+	def prewarm(self):
+		"""
+		Parses all actions and menus that were not parsed yet.
+		Safe to call from another thread.
+		"""
+		for dct in (self.buttons, self.triggers, self.pads, self.menus):
+			for x in list(dct.values()):
+				if isinstance(x, LazyAction):
+					x.materialize()
+		for name in ("stick", "rstick", "gyro"):
+			x = getattr(self, name)
+			if isinstance(x, LazyAction):
+				x.materialize()
+	
+	
 	def clear(self):
 		""" Clears all actions and adds default menu action on center button """
 		self.buttons = { x : NoAction() for x in SCButtons }
@@ -205,6 +249,7 @@ class Profile(object):
 			Profile.DPAD: NoAction(),
 		}
 		self.gyro = NoAction()
+		self.signatures = {}
 	
 	
 	def get_all_actions(self):
@@ -238,6 +283,23 @@ class Profile(object):
 			yield action
 	
 	
+	def get_shell_commands(self):
+		"""
+		Returns set of commands used as 'shell' conditions of modeshift
+		in root actions. Actions that were not parsed yet are parsed only
+		if they may contain such condition.
+		"""
+		rv = set()
+		for action in self.get_actions():
+			if isinstance(action, LazyAction) and not action.is_loaded():
+				if "shell" not in json.dumps(action._data):
+					continue
+			for a in action.get_all_actions():
+				if isinstance(a, ModeModifier):
+					rv.update(a.shell_commands)
+		return rv
+	
+	
 	def get_filename(self):
 		"""
 		Returns filename of last loaded file or None.
@@ -249,10 +311,18 @@ class Profile(object):
 		"""
 		Calls compress on every action to throw out some redundant stuff.
 		Note that calling save() after compress() will cause data loss.
+		
+		Before compressing, signature of every root action that was not loaded
+		from file is generated, so reuse_actions can be used later.
 		"""
-		for dct in (self.buttons, self.triggers, self.pads):
+		for name, dct in (("buttons", self.buttons), ("triggers", self.triggers), ("pads", self.pads)):
 			for x in dct:
+				if (name, x) not in self.signatures:
+					self.signatures[name, x] = Profile.get_signature(dct[x])
 				dct[x] = dct[x].compress()
+		for name in ("stick", "rstick", "gyro"):
+			if name not in self.signatures:
+				self.signatures[name] = Profile.get_signature(getattr(self, name))
 		self.rstick = self.rstick.compress()
 		self.stick = self.stick.compress()
 		self.gyro = self.gyro.compress()
@@ -260,6 +330,61 @@ class Profile(object):
 			menu.compress()
 	
 	
+	@staticmethod
+	def get_signature(action):
+		"""
+		Returns string that is same for every two structurally identical
+		actions, or None if action cannot be encoded.
+		"""
+		try:
+			return Encoder(sort_keys=True).encode(action)
+		except Exception:
+			return None
+	
+	
+	def reuse_actions(self, old, unwrap=None):
+		"""
+		Compares this profile with 'old' one, both of which has to be
+		compressed, and replaces every root action that is bound identically
+		in both profiles with instance from 'old' profile, so its runtime state
+		is kept.
+		
+		If set, 'unwrap' is called with every action from 'old' profile and
+		should return it without temporary wrappers that are not part of
+		profile, such as ones added by daemon when client locks input.
+		
+		Returns (kept, dropped) tuple, where 'kept' is list of reused actions
+		and 'dropped' list of actions from 'old' that were not reused.
+		"""
+		kept, dropped = [], []
+		unwrap = unwrap or (lambda a : a)
+		def reuse(key, container, ckey, old_action, action):
+			old_action = unwrap(old_action)
+			sig = self.signatures.get(key)
+			if sig is not None and sig == old.signatures.get(key):
+				if isinstance(old_action, LazyAction):
+					# Action not parsed yet has to replace itself in this
+					# profile, not in old one
+					old_action = old_action.move(container, ckey)
+				kept.append(old_action)
+				return old_action
+			dropped.append(old_action)
+			return action
+		
+		for name, dct, old_dct in (
+					("buttons", self.buttons, old.buttons),
+					("triggers", self.triggers, old.triggers),
+					("pads", self.pads, old.pads)):
+			for x in old_dct:
+				if x in dct:
+					dct[x] = reuse((name, x), dct, x, old_dct[x], dct[x])
+				else:
+					dropped.append(unwrap(old_dct[x]))
+		for name in ("stick", "rstick", "gyro"):
+			setattr(self, name, reuse(name, self, name, getattr(old, name), getattr(self, name)))
+		return kept, dropped
+	
+	
 	def _convert(self, from_version):
 		""" Performs conversion from older profile version """
 		if from_version < 1:
@@ -344,6 +469,123 @@ class Profile(object):
 			# Action format completly changed in v0.4, but profile foramat is same.
 			pass
 
+class LazyAction(object):
+	"""
+	Stands in place of action that was not parsed yet.
+	
+	Action is parsed from stored json data when it's used for first time.
+	Parsed action then replaces LazyAction in container it was stored in,
+	so there is no overhead after that.
+	
+	Parser is not reentrant and all LazyActions of profile share it, so
+	parsing is serialized by lock owned by parser.
+	"""
+	_loaded = None
+	
+	def __init__(self, parser, data, container, key):
+		self._parser = parser
+		self._data = data
+		self._container = container
+		self._key = key
+		self._compress = False
+	
+	
+	def _parse(self):
+		a = self._parser.from_json_data(self._data)
+		return a.compress() if self._compress else a
+	
+	
+	def materialize(self):
+		""" Parses action, if not parsed already, and returns it """
+		if self._loaded is None:
+			with self._parser.lock:
+				if self._loaded is None:
+					self._loaded = self._parse()
+					self._replace()
+		return self._loaded
+	
+	
+	def _replace(self):
+		""" Replaces self with parsed action in container """
+		if isinstance(self._container, dict):
+			if self._container.get(self._key) is self:
+				self._container[self._key] = self._loaded
+		elif getattr(self._container, self._key, None) is self:
+			setattr(self._container, self._key, self._loaded)
+	
+	
+	def move(self, container, key):
+		"""
+		Changes container in which parsed action will be stored.
+		Returns parsed action if it's available already, or self.
+		"""
+		with self._parser.lock:
+			self._container, self._key = container, key
+			if self._loaded is None:
+				return self
+			return self._loaded
+	
+	
+	def is_loaded(self):
+		return self._loaded is not None
+	
+	
+	def __getattr__(self, name):
+		return getattr(self.materialize(), name)
+	
+	
+	def __nonzero__(self):
+		return bool(self.materialize())
+	
+	
+	def __str__(self):
+		if self._loaded is None:
+			return "<Lazy %s>" % (self._data, )
+		return str(self._loaded)
+	
+	__repr__ = __str__
+	
+	
+	def compress(self):
+		""" Compressing is postponed until action is parsed """
+		self._compress = True
+		return self
+	
+	
+	def cancel(self, mapper):
+		# Action that was never used has nothing to cancel
+		if self._loaded is not None:
+			self._loaded.cancel(mapper)
+	
+	
+	def encode(self):
+		if self._loaded is None:
+			return self._data
+		return self._loaded.encode()
+
+
+class LazyMenu(LazyAction):
+	""" As LazyAction, but for menus embedded in profile """
+	
+	def _parse(self):
+		m = MenuData.from_json_data(self._data, self._parser)
+		if self._compress:
+			m.compress()
+		return m
+	
+	
+	def __len__(self):
+		return len(self.materialize())
+	
+	
+	def __getitem__(self, index):
+		return self.materialize()[index]
+	
+	
+	def __iter__(self):
+		return iter(self.materialize())
+
+
 class Encoder(JSONEncoder):
 	def default(self, obj):
 		#if type(obj) in (list, tuple):
@@ -10,44 +10,75 @@ from scc.lib.daemon import Daemon
 from scc.constants import SCButtons, DAEMON_VERSION, HapticPos
 from scc.constants import LEFT, RIGHT, STICK, RSTICK, CPAD, DPAD
 from scc.tools import find_profile, find_menu, nameof, shsplit, shjoin
-from scc.uinput import CannotCreateUInputException
+from scc.uinput import UInput, CannotCreateUInputException
 from scc.tools import set_logging_level, find_binary, clamp
+from scc.tools import get_file_index, get_profile_list, get_menu_list
 from scc.device_monitor import create_device_monitor
+from scc.shell_conditions import ShellConditions
 from scc.cemuhook_server import CemuhookServer
 from scc.custom import load_custom_module
 from scc.gestures import GestureDetector
+from scc.game_index import GameIndex
 from scc.parser import TalkingActionParser
 from scc.controller import HapticData
 from scc.scheduler import Scheduler
+from scc.spawner import Spawner
 from scc.menu_data import MenuData
 from scc.profile import Profile
 from scc.actions import Action
 from scc.config import Config
 from scc.poller import Poller
+from scc.lib.fdpass import send_fds, recv_fds
 from scc.mapper import Mapper
 from scc import drivers
 
 from SocketServer import UnixStreamServer, ThreadingMixIn, StreamRequestHandler
-import os, sys, pkgutil, signal, time, json, logging
-import threading, traceback, subprocess, shlex
+import os, sys, pkgutil, signal, socket, time, json, logging
+import threading, traceback, subprocess, shlex, itertools, fcntl
 log = logging.getLogger("SCCDaemon")
 tlog = logging.getLogger("Socket Thread")
 
 class ThreadingUnixStreamServer(ThreadingMixIn, UnixStreamServer): daemon_threads = True
 
 
+class StartupTrace(object):
+	"""
+	Measures time taken by each phase of daemon startup.
+	Calling instance records phase that ended just now.
+	"""
+	
+	def __init__(self):
+		self.phases = []
+		self.start = self.last = time.time()
+	
+	
+	def __call__(self, phase):
+		now = time.time()
+		self.phases.append((phase, now - self.last))
+		self.last = now
+	
+	
+	def report(self):
+		log.debug("Startup finished in %.3fs (%s)", self.last - self.start,
+			", ".join([ "%s: %.3fs" % x for x in self.phases ]))
+
+
 class SCCDaemon(Daemon):
+	HANDOVER_TIMEOUT = 10.0		# How long to wait for new instance during handover
+	HANDOVER_MAX_SIZE = 1024 * 1024
 	
 	def __init__(self, piddile, socket_file):
 		set_logging_level(True, True)
 		Daemon.__init__(self, piddile)
-		Config()					# Generates ~/.config/scc and default config if needed
+		Config.get_shared()		# Generates ~/.config/scc and default config if needed
 		self.started = False
 		self.exiting = False
 		self.socket_file = socket_file
 		self.poller = Poller()
 		self.dev_monitor = create_device_monitor(self)
 		self.scheduler = Scheduler()
+		self.spawner = Spawner(self.poller)
+		self.shell_conditions = ShellConditions(self.spawner, self.scheduler)
 		self.xdisplay = None
 		self.sserver = None			# UnixStreamServer instance
 		self.errors = []
@@ -64,11 +95,15 @@ class SCCDaemon(Daemon):
 		self.on_exit_cbs = []
 		self.subprocs = []
 		self.lock = threading.Lock()
+		self.profile_requests = {}	# mapper -> serial of last requested profile
+		self.profile_serial = itertools.count()
 		self.cemuhook = None
 		self.default_mapper = None
 		self.free_mappers = [ ]
 		self.clients = set()
 		self.cwd = os.getcwd()
+		self.handover_fd = None		# Set when started by handover()
+		self.restored_profiles = {}	# controller_id -> profile, set by take_over()
 	
 	
 	def init_drivers(self):
@@ -77,14 +112,18 @@ class SCCDaemon(Daemon):
 		See __init__.py in scc.drivers.
 		"""
 		log.debug("Initializing drivers...")
-		cfg = Config()
+		cfg = Config.get_shared()
 		self._to_start = set()  # del-eted later by start_drivers
 		to_init = []
 		for importer, modname, ispkg in pkgutil.walk_packages(path=drivers.__path__, onerror=lambda x: None):
 			if not ispkg and modname != "driver":
-				if modname == "usb" or cfg["drivers"].get(modname):
+				if modname in drivers.LAZY_DRIVERS and cfg["drivers"].get(modname):
+					# Imported only after handled device is detected
+					self.dev_monitor.add_lazy_callback(drivers.LAZY_DRIVERS[modname],
+						lambda modname=modname: self._init_lazy_driver(modname))
+				elif modname == "usb" or cfg["drivers"].get(modname):
 					# 'usb' driver has to be always active
-					mod = getattr(__import__('scc.drivers.%s' % (modname,)).drivers, modname)
+					mod = self._import_driver(modname)
 					if hasattr(mod, "init"):
 						to_init.append(mod)
 				else:
@@ -100,6 +139,35 @@ class SCCDaemon(Daemon):
 					self._to_start.add(getattr(mod, "start"))
 	
 	
+	def _import_driver(self, modname):
+		t = time.time()
+		mod = getattr(__import__('scc.drivers.%s' % (modname,)).drivers, modname)
+		log.debug("Imported driver '%s' in %.3fs", modname, time.time() - t)
+		return mod
+	
+	
+	def _init_lazy_driver(self, modname):
+		"""
+		Called by device monitor when first device handled by driver
+		listed in LAZY_DRIVERS is detected.
+		"""
+		log.debug("Loading driver '%s' for detected device", modname)
+		try:
+			mod = self._import_driver(modname)
+			if not mod.init(self, Config.get_shared()):
+				return
+		except Exception, e:
+			log.error("Failed to initialize driver '%s'", modname)
+			log.exception(e)
+			return
+		if hasattr(mod, "start"):
+			if hasattr(self, "_to_start"):
+				# start_drivers was not called yet
+				self._to_start.add(mod.start)
+			else:
+				mod.start(self)
+	
+	
 	def init_default_mapper(self):
 		"""
 		default_mapper is persistent mapper assigned to first Controller instance.
@@ -180,10 +248,37 @@ class SCCDaemon(Daemon):
 			self.rescan_cbs.append(fn)
 	
 	
-	def _set_profile(self, mapper, filename):
-		# Called from socket server thread
+	def _request_profile(self, mapper):
+		"""
+		Marks start of profile switch on given mapper and returns serial
+		number that has to be passed to _apply_profile later.
+		Should be called while lock is acquired.
+		"""
+		serial = next(self.profile_serial)
+		self.profile_requests[mapper] = serial
+		return serial
+	
+	
+	def _load_profile(self, filename):
+		"""
+		Loads and compresses profile. Called without lock held, as
+		parsing bigger profile may take a while.
+		"""
 		p = Profile(TalkingActionParser())
-		p.load(filename).compress()
+		p.load(filename, lazy=True).compress()
+		return p
+	
+	
+	def _apply_profile(self, mapper, filename, p, serial=None):
+		"""
+		Switches mapper to already loaded profile. If another profile was
+		requested for same mapper in meantime, does nothing and returns False.
+		
+		Has to be called with self.lock held.
+		"""
+		if serial is not None and self.profile_requests.get(mapper) != serial:
+			log.debug("Not applying '%s', newer profile was requested", filename)
+			return False
 		self.profile_file = filename
 		
 		if mapper.profile.gyro and not p.gyro:
@@ -196,15 +291,17 @@ class SCCDaemon(Daemon):
 			if mapper.get_controller():
 				log.debug("Turning gyrosensor ON")
 				mapper.get_controller().set_gyro_enabled(True)
-		# Cancel everything
-		mapper.cancel_all()
-		# Release all buttons
-		mapper.release_virtual_buttons()
-		# Reset mouse (issue #222)
-		mapper.mouse.reset()
-		
-		# This last line kinda depends on GIL...
-		mapper.profile = p
+		# Cancel and release only what was changed
+		# This kinda depends on GIL...
+		# Client locks are not part of profile and are re-applied below
+		kept = mapper.switch_profile(p, ReportingAction.unwrap)
+		log.debug("Kept %s unchanged bindings", kept)
+		if Config.get_shared()["prewarm_profiles"]:
+			self._prewarm_profile(p)
+		# Results of 'shell' conditions should be known before they are
+		# needed for first time. Commands are started from mainloop,
+		# as this may be called from another thread.
+		mapper.schedule(0, self._evaluate_shell_conditions)
 		# Re-apply all locks
 		for c in self.clients:
 			c.reaply_locks(self, mapper)
@@ -212,6 +309,23 @@ class SCCDaemon(Daemon):
 			self.send_profile_info(mapper.get_controller(), self._send_to_all)
 		else:
 			self.send_profile_info(None, self._send_to_all, mapper=mapper)
+		return True
+	
+	
+	def _evaluate_shell_conditions(self, mapper):
+		""" Starts evaluating all 'shell' conditions used by mapper's profile """
+		for command in mapper.profile.get_shell_commands():
+			self.shell_conditions.evaluate(command)
+	
+	
+	def _prewarm_profile(self, p):
+		"""
+		Parses all actions of lazily loaded profile in background,
+		so nothing has to be parsed when action is used for first time.
+		"""
+		t = threading.Thread(target=p.prewarm)
+		t.daemon = True
+		t.start()
 	
 	
 	def _send_to_all(self, message_str):
@@ -234,12 +348,115 @@ class SCCDaemon(Daemon):
 	
 	def on_sa_restart(self, *a):
 		""" Called when 'restart' action is used """
+		t = threading.Thread(target=self.handover)
+		t.daemon = True
+		t.start()
+	
+	
+	def _restart(self):
+		""" Restarts daemon by stopping it and starting new instance """
 		with self.lock:
 			for c in self.clients:
 				c.close()
 		os.system("%s %s None restart &" % ( sys.executable, sys.argv[0] ))
 	
 	
+	def handover(self):
+		"""
+		Restarts daemon without destroying virtual devices.
+		
+		New daemon process is started with unix socket as its stdin and all
+		uinput devices, together with profiles assigned to controllers, are
+		passed to it over that socket. This instance exits once new one
+		confirms it got everything. If that fails, plain restart is done.
+		"""
+		devices = []
+		a, b = socket.socketpair(socket.AF_UNIX, socket.SOCK_SEQPACKET)
+		try:
+			with self.lock:
+				# Mappers are ordered as new instance creates them
+				mappers = []
+				for m in ([ self.default_mapper ] + self.free_mappers +
+						[ c.get_mapper() for c in self.controllers ]):
+					if m is not None and m not in mappers:
+						mappers.append(m)
+				for m in mappers:
+					m.release_virtual_buttons()
+					devices += [ d for d in (m.keyboard, m.mouse, m.gamepad)
+						if isinstance(d, UInput) ]
+				state = {
+					"pid" : os.getpid(),
+					"default_profile" : self.default_mapper.profile.get_filename(),
+					"profiles" : { c.get_id() : c.get_mapper().profile.get_filename()
+						for c in self.controllers if c.get_mapper() },
+					"devices" : [ d.signature for d in devices ],
+				}
+			args = [ sys.executable, sys.argv[0], "start" ]
+			if self.alone:
+				args.append("--alone")
+			env = dict(os.environ, SCC_HANDOVER="1")
+			subprocess.Popen(args, stdin=b, close_fds=True, cwd=self.cwd, env=env)
+			b.close()
+			send_fds(a, json.dumps(state).encode("utf-8"),
+				[ d.getDescriptor() for d in devices ])
+			a.settimeout(SCCDaemon.HANDOVER_TIMEOUT)
+			if a.recv(16) != b"OK":
+				raise Exception("new instance didn't confirm handover")
+		except Exception, e:
+			log.error("Handover failed, restarting: %s", e)
+			a.close()
+			self._restart()
+			return
+		
+		log.info("Handed %s virtual devices over to new instance", len(devices))
+		a.close()
+		for d in devices:
+			d.detach()
+		with self.lock:
+			for c in self.clients:
+				c.close()
+		os.kill(os.getpid(), signal.SIGTERM)
+	
+	
+	def take_over(self):
+		"""
+		Receives virtual devices and state from previous daemon instance
+		if this one was started by handover(), then waits until previous
+		instance exits and releases controllers.
+		"""
+		if self.handover_fd is None:
+			return
+		try:
+			sock = socket.fromfd(self.handover_fd, socket.AF_UNIX, socket.SOCK_SEQPACKET)
+			os.close(self.handover_fd)
+			data, fds = recv_fds(sock, SCCDaemon.HANDOVER_MAX_SIZE)
+			state = json.loads(data.decode("utf-8"))
+			for signature, fd in zip(state["devices"], fds):
+				UInput.inherit(signature, fd)
+			if self.default_profile is None:
+				self.default_profile = state["default_profile"]
+			self.restored_profiles = state["profiles"]
+			sock.send(b"OK")
+			sock.close()
+		except Exception, e:
+			log.error("Failed to take over from previous instance: %s", e)
+			return
+		finally:
+			self.handover_fd = None
+		
+		deadline = time.time() + SCCDaemon.HANDOVER_TIMEOUT
+		while time.time() < deadline:
+			try:
+				os.kill(state["pid"], 0)
+			except OSError:
+				# Exited
+				break
+			time.sleep(0.01)
+		# Devices not claimed by any mapper until then are no longer needed
+		self.scheduler.schedule(SCCDaemon.HANDOVER_TIMEOUT, UInput.destroy_inherited)
+		log.info("Took over %s virtual devices from previous instance", len(fds))
+	
+	
 	def on_sa_led(self, mapper, action):
 		""" Called when 'led' action is used """
 		if mapper.get_controller():
@@ -248,7 +465,15 @@ class SCCDaemon(Daemon):
 	
 	def on_sa_shell(self, mapper, action):
 		""" Called when 'shell' action is used """
-		return subprocess.Popen(action.command, shell=True)
+		self.spawner.spawn(action.command)
+	
+	
+	def on_sa_shell_condition(self, mapper, action):
+		"""
+		Called when 'shell' is used as modeshift condition.
+		Returns last known result of command.
+		"""
+		return self.shell_conditions.get(action.command)
 	
 	
 	def on_sa_gestures(self, mapper, action, x, y, what):
@@ -267,11 +492,13 @@ class SCCDaemon(Daemon):
 			else:
 				# Otherwise it is handled internally
 				up_direction = 0
+				matcher = action.get_matcher()
 				gd = self._start_gesture(
 					mapper,
 					what,
 					up_direction,
-					lambda gesture_string : action.gesture(mapper, gesture_string)
+					lambda gesture_string : action.gesture(mapper, gesture_string, matcher),
+					matcher
 				)
 		if gd:
 			gd.enable()
@@ -387,15 +614,67 @@ class SCCDaemon(Daemon):
 		path = find_profile(name)
 		if path:
 			with self.lock:
-				try:
-					self._set_profile(mapper, path)
-					log.info("Loaded profile '%s'", name)
-				except Exception, e:
-					log.exception(e)
+				serial = self._request_profile(mapper)
+			self._load_profile_async(mapper, path, serial,
+				lambda: log.info("Loaded profile '%s'", name))
 			return
 		log.error("Cannot load profile: Profile '%s' not found", name)
 	
 	
+	def _load_profile_async(self, mapper, filename, serial, callback, reload=False):
+		"""
+		Loads profile in separate thread, so input thread is not blocked
+		meanwhile, and switches mapper to it. Callback is called with lock
+		held after profile is applied.
+		
+		If 'reload' is True, profile is applied only if mapper still uses
+		same file and no other profile was requested in meantime.
+		"""
+		def load():
+			try:
+				p = self._load_profile(filename)
+				with self.lock:
+					if reload:
+						if self.profile_requests.get(mapper) != serial:
+							return
+						if mapper.profile.get_filename() != filename:
+							return
+					if self._apply_profile(mapper, filename, p, serial):
+						callback()
+			except Exception, e:
+				log.exception(e)
+		
+		t = threading.Thread(target=load)
+		t.daemon = True
+		t.start()
+	
+	
+	def reload_changed_profiles(self):
+		"""
+		Checks if file of any active profile was modified and reloads
+		it if needed. Only changed bindings are replaced when profile is
+		applied, so unchanged inputs are not disturbed.
+		"""
+		with self.lock:
+			mappers = [ c.get_mapper() for c in self.controllers if c.get_mapper() ]
+			mappers += [ m for m in self.free_mappers if m not in mappers ]
+			to_reload = [
+				(m, m.profile.get_filename(), m.profile.mtime,
+					self.profile_requests.get(m))
+				for m in mappers if m.profile.get_filename()
+			]
+		for mapper, filename, mtime, serial in to_reload:
+			try:
+				if os.stat(filename).st_mtime == mtime:
+					continue
+			except OSError:
+				# Removed, current profile is kept
+				continue
+			log.info("Profile '%s' was modified, reloading", filename)
+			self._load_profile_async(mapper, filename, serial,
+				lambda f=filename: log.info("Reloaded profile '%s'", f), reload=True)
+	
+	
 	def on_start(self):
 		os.chdir(self.cwd)
 	
@@ -442,7 +721,7 @@ class SCCDaemon(Daemon):
 				m.set_xdisplay(self.xdisplay)
 			if not self.alone:
 				self.subprocs.append(Subprocess("scc-osd-daemon", True))
-				if len(Config()["autoswitch"]):
+				if len(Config.get_shared()["autoswitch"]):
 					# Start scc-autoswitch-daemon only if there are some switch rules defined
 					self.subprocs.append(Subprocess("scc-autoswitch-daemon", True))
 		else:
@@ -473,7 +752,7 @@ class SCCDaemon(Daemon):
 	
 	def fix_xinput(self, mapper):
 		name = mapper.get_gamepad_name()
-		if self.xdisplay and Config()["fix_xinput"] and name:
+		if self.xdisplay and Config.get_shared()["fix_xinput"] and name:
 			# Three conditions: X has to be available, 'fix_xinput' must
 			# be enabled in config and controller should not be dummy
 			# (should have a name)
@@ -491,12 +770,14 @@ class SCCDaemon(Daemon):
 		mapper = mapper or self.default_mapper
 		if self.default_profile == None:
 			try:
-				self.default_profile = find_profile(Config()["recent_profiles"][0])
+				self.default_profile = find_profile(Config.get_shared()["recent_profiles"][0])
 			except:
 				# Broken config is not reason to fail here
 				pass
 		try:
-			mapper.profile.load(self.default_profile).compress()
+			mapper.profile.load(self.default_profile, lazy=True).compress()
+			if Config.get_shared()["prewarm_profiles"]:
+				self._prewarm_profile(mapper.profile)
 		except Exception, e:
 			log.warning("Failed to load profile. Starting with no mappings.")
 			log.warning("Reason: %s", e)
@@ -517,11 +798,18 @@ class SCCDaemon(Daemon):
 		c.set_mapper(mapper)
 		if mapper == self.default_mapper:
 			log.debug("Assigned default_mapper to %s", c)
+		filename = self.restored_profiles.pop(c.get_id(), None)
+		if filename and filename != mapper.profile.get_filename():
+			# Controller had different profile before daemon was restarted
+			with self.lock:
+				serial = self._request_profile(mapper)
+			self._load_profile_async(mapper, filename, serial,
+				lambda: log.info("Restored profile '%s' for %s", filename, c))
 		if mapper.profile.gyro:
 			log.debug("Turning gyrosensor ON")
 			c.set_gyro_enabled(True)
 		
-		c.apply_config(Config().get_controller_config(c.get_id()))
+		c.apply_config(Config.get_shared().get_controller_config(c.get_id()))
 		self.controllers.append(c)
 		log.debug("Controller added: %s", c)
 		with self.lock:
@@ -635,21 +923,91 @@ class SCCDaemon(Daemon):
 			self.send_profile_info(None, method, mapper=self.default_mapper)
 	
 	
+	def start_file_index(self):
+		"""
+		Lists profile and menu directories and starts watching them
+		for changes, so clients can be notified.
+		"""
+		index = get_file_index()
+		get_profile_list(), get_menu_list()
+		self._index_serial = index.serial
+		if index.fileno() is not None:
+			self.poller.register(index.fileno(), self.poller.POLLIN, self.on_index_changed)
+	
+	
+	def on_index_changed(self, *a):
+		""" Called when something in profile or menu directories changes """
+		serial = get_file_index().refresh()
+		if serial != self._index_serial:
+			self._index_serial = serial
+			with self.lock:
+				self._send_to_all(b"Index changed.\n")
+			self.reload_changed_profiles()
+	
+	
+	def send_index(self, method):
+		"""
+		Sends list of all available profiles and menus using provided method.
+		Each is sent as
+			Indexed profile: <mtime> <is_override> <filename>
+		or
+			Indexed menu: <mtime> <is_override> <filename>
+		"""
+		for kind, lst in (("profile", get_profile_list()), ("menu", get_menu_list())):
+			for name in sorted(lst):
+				filename, is_override, mtime = lst[name]
+				method(("Indexed %s: %s %s %s\n" % (
+					kind, mtime, int(is_override), filename
+				)).encode("utf-8"))
+	
+	
+	def start(self):
+		if "SCC_HANDOVER" in os.environ:
+			# Started by handover(). Socket is on stdin, which gets
+			# replaced while daemonizing, so it has to be kept elsewhere.
+			del os.environ["SCC_HANDOVER"]
+			self.handover_fd = os.dup(sys.stdin.fileno())
+			flags = fcntl.fcntl(self.handover_fd, fcntl.F_GETFD)
+			fcntl.fcntl(self.handover_fd, fcntl.F_SETFD, flags | fcntl.FD_CLOEXEC)
+			Daemon.start(self, force=True)
+		else:
+			Daemon.start(self)
+	
+	
 	def run(self):
 		log.debug("Starting SCCDaemon...")
+		trace = StartupTrace()
+		# Forked while daemon is still small, see scc.spawner
+		self.spawner.start()
 		signal.signal(signal.SIGTERM, self.sigterm)
+		trace("spawner")
+		self.take_over()
+		trace("take_over")
 		self.init_drivers()
+		trace("init_drivers")
 		self.dev_monitor.start()
+		trace("dev_monitor")
 		load_custom_module(log)
+		trace("custom_module")
 		self.default_mapper = self.init_default_mapper()
 		self.free_mappers.append(self.default_mapper)
+		trace("default_mapper")
 		self.load_default_profile()
+		trace("default_profile")
 		self.lock.acquire()
 		self.start_listening()
 		self.connect_x()
 		self.lock.release()
+		trace("listening")
 		self.start_drivers()
+		trace("start_drivers")
 		self.dev_monitor.rescan()
+		trace("rescan")
+		self.game_index = GameIndex()
+		self.game_index.start(self)
+		self.start_file_index()
+		trace("indexes")
+		trace.report()
 		
 		while True:
 			for fn in self.mainloops:
@@ -673,10 +1031,11 @@ class SCCDaemon(Daemon):
 		log.debug("Created control socket %s", self.socket_file)
 	
 	
-	def _start_gesture(self, mapper, what, up_angle, callback):
+	def _start_gesture(self, mapper, what, up_angle, callback, matcher=None):
 		"""
 		Starts gesture detection on specified pad.
 		Calls callback with gesture string when finished.
+		If set, 'matcher' is fed with gesture while it's being drawn.
 		
 		Should be called with lock held.
 		"""
@@ -699,7 +1058,7 @@ class SCCDaemon(Daemon):
 				gd.original_action = action
 				return gd
 		
-		gd = GestureDetector(up_angle, cb)
+		gd = GestureDetector(up_angle, cb, matcher)
 		self._apply(mapper, what, set)
 		return gd	
 	
@@ -745,16 +1104,22 @@ class SCCDaemon(Daemon):
 		Handles message recieved from client.
 		"""
 		if message.startswith("Profile:"):
+			filename = message[8:].strip("\t ")
 			with self.lock:
-				try:
-					filename = message[8:].strip("\t ")
-					self._set_profile(client.mapper, filename)
-					log.info("Loaded profile '%s'", filename)
+				serial = self._request_profile(client.mapper)
+			try:
+				# Profile is loaded without holding lock, only switching
+				# to it has to be done while lock is acquired
+				p = self._load_profile(filename)
+				with self.lock:
+					if self._apply_profile(client.mapper, filename, p, serial):
+						log.info("Loaded profile '%s'", filename)
 					client.wfile.write(b"OK.\n")
-				except Exception, e:
-					exc = traceback.format_exc()
-					log.exception(e)
-					tb = unicode(exc).encode("utf-8").encode('string_escape')
+			except Exception, e:
+				exc = traceback.format_exc()
+				log.exception(e)
+				tb = unicode(exc).encode("utf-8").encode('string_escape')
+				with self.lock:
 					client.wfile.write(b"Fail: " + tb + b"\n")
 		elif message.startswith("OSD:"):
 			if not self.osd_daemon:
@@ -781,6 +1146,10 @@ class SCCDaemon(Daemon):
 			except Exception, e:
 				log.exception(e)
 				client.wfile.write(b"Fail: %s\n" % (e,))
+		elif message.startswith("Index."):
+			with self.lock:
+				self.send_index(client.wfile.write)
+				client.wfile.write(b"OK.\n")
 		elif message.startswith("Controller."):
 			with self.lock:
 				client.mapper = self.default_mapper
@@ -799,7 +1168,7 @@ class SCCDaemon(Daemon):
 				except Exception, e:
 					client.wfile.write(b"Fail: no such controller\n")
 		elif message.startswith("State."):
-			if Config()["enable_sniffing"]:
+			if Config.get_shared()["enable_sniffing"]:
 				client.wfile.write(b"State: %s\n" % (str(client.mapper.state), ))
 			else:
 				log.warning("Refused 'State' request: Sniffing disabled")
@@ -814,7 +1183,7 @@ class SCCDaemon(Daemon):
 			if client.mapper.get_controller():
 				client.mapper.get_controller().set_led_level(number)
 		elif message.startswith("Observe:"):
-			if Config()["enable_sniffing"]:
+			if Config.get_shared()["enable_sniffing"]:
 				to_observe = [ x for x in message.split(":", 1)[1].strip(" \t\r").split(" ") ]
 				with self.lock:
 					for l in to_observe:
@@ -864,7 +1233,7 @@ class SCCDaemon(Daemon):
 		elif message.startswith("Reconfigure."):
 			with self.lock:
 				# Load config
-				cfg = Config()
+				cfg = Config.get_shared()
 				# Reconfigure connected controllers
 				for c in self.controllers:
 					c.apply_config(cfg.get_controller_config(c.get_id()))
@@ -1216,6 +1585,14 @@ class ReportingAction(Action):
 		self.old_pos = 0, 0
 	
 	
+	@staticmethod
+	def unwrap(action):
+		""" Returns action with all locks and observers removed """
+		while isinstance(action, ReportingAction):
+			action = action.original_action
+		return action
+	
+	
 	def _store_lock(self):
 		if self.mapper not in self.client.locked_actions:
 			self.client.locked_actions[self.mapper] = set()
@@ -106,6 +106,139 @@ def cmd_list_profiles(argv0, argv):
 	return 0
 
 
+def cmd_convert_vdf(argv0, argv):
+	"""
+	Converts Steam controller configurations to profiles
+	
+	Converts every VDF, legacy bin-VDF and VDFFZ file found in directory
+	(and its subdirectories) to .sccprofile. Files are converted in
+	parallel, profile is not converted again if it's newer than source file.
+	
+	Usage: scc convert-vdf [-f] [-j jobs] source_directory [target_directory]
+	
+	Arguments:
+	  -f       Convert all files, even if profile is up to date
+	  -j jobs  Number of files converted at once (default: number of CPUs)
+	
+	Profiles are stored in ~/.config/scc/profiles if target_directory
+	is not specified. Action sets are stored as additional hidden profiles.
+	
+	Return codes:
+	  0 - all files converted or up to date
+	  1 - invalid arguments
+	  2 - conversion of one or more files failed
+	"""
+	import multiprocessing
+	from scc.paths import get_profiles_path
+	force, jobs, paths = False, multiprocessing.cpu_count(), []
+	args = list(argv)
+	while args:
+		arg = args.pop(0)
+		if arg == "-f":
+			force = True
+		elif arg == "-j":
+			try:
+				jobs = max(1, int(args.pop(0)))
+			except (IndexError, ValueError):
+				raise InvalidArguments()
+		else:
+			paths.append(arg)
+	if len(paths) not in (1, 2) or not os.path.isdir(paths[0]):
+		raise InvalidArguments()
+	source = paths[0]
+	target = paths[1] if len(paths) > 1 else get_profiles_path()
+	if not os.path.exists(target):
+		os.makedirs(target)
+	
+	todo, skipped = [], 0
+	for path, dirnames, filenames in os.walk(source):
+		dirnames.sort()
+		for f in sorted(filenames):
+			if not f.endswith((".vdf", ".bin", ".vdffz")):
+				continue
+			filename = os.path.join(path, f)
+			# Name is generated from path, so files with same name in
+			# different subdirectories don't overwrite each other
+			name = os.path.splitext(os.path.relpath(filename, source))[0]
+			name = name.replace(os.path.sep, "_").lstrip(".")
+			output = os.path.join(target, name + ".sccprofile")
+			if not force and os.path.exists(output):
+				if os.stat(output).st_mtime >= os.stat(filename).st_mtime:
+					skipped += 1
+					continue
+			todo.append(( filename, name, target ))
+	
+	failed = 0
+	if todo:
+		pool = multiprocessing.Pool(min(jobs, len(todo)))
+		try:
+			for filename, error, warnings in pool.imap_unordered(_convert_vdf, todo):
+				if error:
+					failed += 1
+					print >>sys.stderr, "Failed: %s: %s" % (filename, error)
+				else:
+					print "Converted: %s" % (filename,)
+				for line in warnings:
+					print >>sys.stderr, "  %s" % (line,)
+			pool.close()
+		except:
+			pool.terminate()
+			raise
+		finally:
+			pool.join()
+	
+	print "%s converted, %s up to date, %s failed" % (
+		len(todo) - failed, skipped, failed)
+	return 2 if failed else 0
+
+
+def _convert_vdf(job):
+	"""
+	Converts one file for cmd_convert_vdf. Runs in worker process.
+	Returns (filename, error message or None, list of logged warnings).
+	"""
+	from scc.foreign.vdffz import VDFFZProfile
+	from scc.foreign.vdf import VDFProfile
+	from cStringIO import StringIO
+	import logging
+	filename, name, target = job
+	
+	log_output = StringIO()
+	handler = logging.StreamHandler(log_output)
+	handler.setLevel(logging.WARNING)
+	logging.getLogger().addHandler(handler)
+	try:
+		if filename.endswith(".vdffz"):
+			profile = VDFFZProfile().load(filename)
+		else:
+			profile = VDFProfile().load(filename)
+		
+		def aset_name(set_name):
+			# Same naming as used by import dialog in GUI
+			if set_name == 'default':
+				return name
+			return "." + name + ":" + set_name.lower()
+		
+		for x in profile.action_set_switches:
+			id = int(x._profile.split(":")[-1])
+			x._profile = aset_name(profile.action_set_by_id(id))
+		# Main profile is saved last, so it's not considered up to date
+		# if conversion is interrupted
+		for k in sorted(profile.action_sets, key = lambda x : x == 'default'):
+			output = os.path.join(target, aset_name(k) + ".sccprofile")
+			profile.action_sets[k].save(output + ".tmp")
+			os.rename(output + ".tmp", output)
+		error = None
+	except Exception, e:
+		error = str(e) or e.__class__.__name__
+	except KeyboardInterrupt:
+		error = "interrupted"
+	finally:
+		logging.getLogger().removeHandler(handler)
+	
+	return filename, error, [ x for x in log_output.getvalue().split("\n") if x ]
+
+
 def cmd_set_profile(argv0, argv):
 	"""
 	Sets controller profile
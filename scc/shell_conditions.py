@@ -0,0 +1,84 @@
+#!/usr/bin/env python2
+"""
+SC-Controller - Shell Conditions
+
+Evaluates 'shell' commands used as conditions in modeshift on background
+and remembers their results, so pressing button never has to wait for
+command to finish.
+
+Result is considered fresh for 'shell_condition_ttl' seconds (see config).
+When older result is requested, it's returned anyway and command is
+executed again on background. Additionally, commands used since last
+refresh are executed again every 'shell_condition_ttl' seconds, so result
+is usually fresh already when button is pressed.
+
+Commands are executed by scc.spawner, which reports their exit codes
+through daemon's poller.
+"""
+from __future__ import unicode_literals
+
+from scc.config import Config
+
+import time, logging
+log = logging.getLogger("ShellCond")
+
+
+class ShellConditions(object):
+	KILL_TIMEOUT = 5.0		# command running for longer than this is killed
+	LOST_TIMEOUT = 10.0		# command not reported even after this is forgotten
+	
+	def __init__(self, spawner, scheduler):
+		self.spawner = spawner
+		self.scheduler = scheduler
+		self.ttl = Config.get_shared()["shell_condition_ttl"]
+		self._results = {}		# command -> (time, result)
+		self._running = {}		# command -> (spawner id, start time)
+		self._used = set()		# commands requested since last refresh
+		self._task = None
+	
+	
+	def get(self, command):
+		"""
+		Returns last known result of command, or False if command was
+		never executed before. Never blocks.
+		"""
+		self._used.add(command)
+		t, result = self._results.get(command, (0, False))
+		if time.time() - t > self.ttl:
+			self.evaluate(command)
+		if self._task is None:
+			self._task = self.scheduler.schedule(self.ttl, self._refresh)
+		return result
+	
+	
+	def evaluate(self, command):
+		""" Executes command on background, unless it's running already """
+		if command in self._running:
+			return
+		id = self.spawner.spawn(command, lambda code: self._on_exit(command, code))
+		if id is not None:
+			self._running[command] = id, time.time()
+	
+	
+	def _on_exit(self, command, code):
+		del self._running[command]
+		self._results[command] = time.time(), code == 0
+	
+	
+	def _refresh(self):
+		""" Executes recently used commands again """
+		self._task = None
+		self.ttl = Config.get_shared()["shell_condition_ttl"]
+		now = time.time()
+		for command, (id, start) in self._running.items():
+			if now - start > ShellConditions.LOST_TIMEOUT:
+				# Happens only if helper process dies
+				del self._running[command]
+			elif now - start > ShellConditions.KILL_TIMEOUT:
+				log.warning("Killing '%s', it takes too long", command)
+				self.spawner.kill(id)
+		used, self._used = self._used, set()
+		for command in used:
+			self.evaluate(command)
+		if used:
+			self._task = self.scheduler.schedule(self.ttl, self._refresh)
@@ -0,0 +1,191 @@
+#!/usr/bin/env python2
+"""
+SC-Controller - Spawner
+
+Small helper process forked right after daemon starts, while it's still
+small. Daemon sends commands to it over socket and helper forks and
+executes them, so daemon itself doesn't have to fork with all controllers,
+profiles and virtual devices loaded. Exit codes are sent back and passed
+to callbacks from daemon's poller.
+
+Messages are sent over SOCK_SEQPACKET socketpair, one per packet:
+	daemon -> helper:	"spawn <id> <command>", "kill <id>"
+	helper -> daemon:	"exit <id> <exit code>"
+Exit code of command killed by signal is -signal, as with subprocess.
+"""
+from __future__ import unicode_literals
+
+import os, fcntl, errno, select, signal, socket, logging, itertools
+log = logging.getLogger("Spawner")
+
+
+class Spawner(object):
+	MAX_SIZE = 64 * 1024	# max size of message, limits length of command
+	
+	def __init__(self, poller):
+		self.poller = poller
+		self._sock = None
+		self._pid = None
+		self._ids = itertools.count(1)
+		self._callbacks = {}	# id -> callback
+	
+	
+	def start(self):
+		""" Forks helper process """
+		parent, child = socket.socketpair(socket.AF_UNIX, socket.SOCK_SEQPACKET)
+		pid = os.fork()
+		if pid == 0:
+			# Helper
+			parent.close()
+			try:
+				Spawner._helper(child)
+			finally:
+				os._exit(0)
+		child.close()
+		flags = fcntl.fcntl(parent.fileno(), fcntl.F_GETFD)
+		fcntl.fcntl(parent.fileno(), fcntl.F_SETFD, flags | fcntl.FD_CLOEXEC)
+		parent.setblocking(False)
+		self._sock, self._pid = parent, pid
+		self.poller.register(parent.fileno(), self.poller.POLLIN, self._on_data)
+		log.debug("Started helper process %s", pid)
+	
+	
+	def spawn(self, command, callback=None):
+		"""
+		Executes command using shell. If set, callback is called
+		as callback(exit_code) once command exits.
+		Returns id that can be used to kill command, or None if command
+		couldn't be passed to helper process.
+		"""
+		id = self._ids.next()
+		if not self._send(b"spawn %s %s" % (id, command.encode("utf-8"))):
+			return None
+		if callback:
+			self._callbacks[id] = callback
+		return id
+	
+	
+	def kill(self, id):
+		""" Kills command started by spawn """
+		self._send(b"kill %s" % (id,))
+	
+	
+	def _send(self, message):
+		""" Sends message, restarting helper if needed. Returns True on success """
+		for attempt in (1, 2):
+			if self._sock is None:
+				self.start()
+			try:
+				self._sock.send(message)
+				return True
+			except socket.error, e:
+				log.error("Failed to send request to helper: %s", e)
+				self._stop()
+		return False
+	
+	
+	def _stop(self):
+		# Exit codes of commands started by old helper will never be known
+		self._callbacks = {}
+		self.poller.unregister(self._sock.fileno())
+		self._sock.close()
+		self._sock = None
+		try:
+			os.waitpid(self._pid, os.WNOHANG)
+		except OSError:
+			pass
+	
+	
+	def _on_data(self, *a):
+		while self._sock:
+			try:
+				data = self._sock.recv(Spawner.MAX_SIZE)
+			except socket.error, e:
+				if e.errno in (errno.EAGAIN, errno.EWOULDBLOCK):
+					return
+				data = b""
+			if not data:
+				log.warning("Helper process died")
+				self._stop()
+				return
+			trash, id, code = data.split(b" ")
+			cb = self._callbacks.pop(int(id), None)
+			if cb:
+				cb(int(code))
+	
+	
+	@staticmethod
+	def _helper(sock):
+		""" Main loop of helper process """
+		# Nothing daemon had opened before fork, such as handover socket,
+		# should be kept open by helper or passed to executed commands
+		try:
+			max_fd = os.sysconf(b"SC_OPEN_MAX")
+		except (ValueError, OSError):
+			max_fd = 1024
+		os.closerange(3, sock.fileno())
+		os.closerange(sock.fileno() + 1, max_fd)
+		rfd, wfd = os.pipe()
+		for fd in (sock.fileno(), rfd, wfd):
+			fcntl.fcntl(fd, fcntl.F_SETFD, fcntl.FD_CLOEXEC)
+		fcntl.fcntl(wfd, fcntl.F_SETFL, os.O_NONBLOCK)
+		signal.signal(signal.SIGTERM, signal.SIG_DFL)
+		signal.signal(signal.SIGCHLD, lambda *a: None)
+		signal.set_wakeup_fd(wfd)
+		running = {}		# pid -> id
+		while True:
+			try:
+				r, trash, trash = select.select([ sock, rfd ], [], [])
+			except select.error:
+				# EINTR
+				r = [ rfd ]
+			if rfd in r:
+				try:
+					os.read(rfd, 1024)
+				except OSError:
+					pass
+				Spawner._reap(sock, running)
+			if sock in r:
+				data = sock.recv(Spawner.MAX_SIZE)
+				if not data:
+					# Daemon exited
+					return
+				if data.startswith(b"spawn "):
+					trash, id, command = data.split(b" ", 2)
+					try:
+						pid = os.fork()
+					except OSError:
+						sock.send(b"exit %s 127" % (id,))
+						continue
+					if pid == 0:
+						try:
+							os.execv(b"/bin/sh", [ b"sh", b"-c", command ])
+						finally:
+							os._exit(127)
+					running[pid] = id
+				elif data.startswith(b"kill "):
+					trash, id = data.split(b" ")
+					for pid in running:
+						if running[pid] == id:
+							try:
+								os.kill(pid, signal.SIGKILL)
+							except OSError:
+								pass
+	
+	
+	@staticmethod
+	def _reap(sock, running):
+		""" Collects all exited children """
+		while running:
+			try:
+				pid, status = os.waitpid(-1, os.WNOHANG)
+			except OSError:
+				return
+			if pid == 0:
+				return
+			if pid in running:
+				if os.WIFSIGNALED(status):
+					code = -os.WTERMSIG(status)
+				else:
+					code = os.WEXITSTATUS(status)
+				sock.send(b"exit %s %s" % (running.pop(pid), code))
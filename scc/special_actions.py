@@ -18,7 +18,7 @@ from scc.actions import HapticEnabledAction, OSDEnabledAction
 from scc.actions import MOUSE_BUTTONS
 from scc.tools import strip_gesture, nameof, clamp
 from scc.modifiers import Modifier, NameModifier
-from difflib import get_close_matches
+from scc.gesture_index import GestureIndex
 from math import sqrt
 
 import sys, time, logging
@@ -643,6 +643,7 @@ class GesturesAction(Action, OSDEnabledAction, SpecialAction):
 		Action.__init__(self, *stuff)
 		self.gestures = {}
 		self.precision = self.DEFAULT_PRECISION
+		self._index = None
 		gstr = None
 		
 		if len(stuff) > 0 and type(stuff[0]) in (int, float):
@@ -701,6 +702,7 @@ class GesturesAction(Action, OSDEnabledAction, SpecialAction):
 				del self.gestures[gstr]
 				gstr = strip_gesture(gstr)
 			self.gestures[gstr] = a
+		self._index = GestureIndex(self.gestures, self.precision)
 		return self
 	
 	
@@ -718,33 +720,21 @@ class GesturesAction(Action, OSDEnabledAction, SpecialAction):
 			ga = OSDAction(ga)
 		return ga
 
-	def _find_exact_gesture(self, gesture_string):
-		return self.gestures.get(gesture_string)
+	def get_index(self):
+		""" Returns GestureIndex of gestures, building it if needed """
+		if self._index is None:
+			self._index = GestureIndex(self.gestures, self.precision)
+		return self._index
 
-	def _find_ignore_stroke_count_gesture(self, gesture_string):
-		stripped_gesture_string = strip_gesture(gesture_string)
-		return self.gestures.get(stripped_gesture_string)
+	def get_matcher(self):
+		""" Returns GestureMatcher to be fed by GestureDetector """
+		return self.get_index().matcher()
 
-	def _find_best_match_gesture(self, gesture_string):
-		NUM_MATCHES_TO_RETURN = 1
-	
-		similar_gestures = get_close_matches(gesture_string, self.gestures.keys(), NUM_MATCHES_TO_RETURN, self.precision)
-		best_gesture = next(iter(similar_gestures), None)
-
-		if best_gesture is not None:
-			return self.gestures[best_gesture]
-		else:
-			return None
-
-	def find_gesture_action(self, gesture_string):
-		action = None
-		action = action or self._find_exact_gesture(gesture_string)
-		action = action or self._find_ignore_stroke_count_gesture(gesture_string)
-		action = action or self._find_best_match_gesture(gesture_string)
-		return action
+	def find_gesture_action(self, gesture_string, matcher=None):
+		return self.get_index().find(gesture_string, matcher)
 
-	def gesture(self, mapper, gesture_string):
-		action = self.find_gesture_action(gesture_string)
+	def gesture(self, mapper, gesture_string, matcher=None):
+		action = self.find_gesture_action(gesture_string, matcher)
 		if action:
 			action.button_press(mapper)
 			mapper.schedule(0, action.button_release)
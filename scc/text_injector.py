@@ -0,0 +1,275 @@
+#!/usr/bin/env python2
+"""
+SC-Controller - Text Injector
+
+Types arbitrary text on emulated keyboard. Used by type() macro.
+
+Characters are converted to keys and modifiers using keyboard layout
+currently active in X server. Characters not available in that layout
+are typed by temporarily assigning them to unused keycode. Without X
+server, US layout is assumed.
+
+Keys are sent to uinput in batches, one write per mainloop iteration. If
+'delay' is set, one character is typed every 'delay' seconds instead.
+Caller that has to wait until text is typed, such as macro, can pass
+callback that's called once last character is sent.
+"""
+from __future__ import unicode_literals
+
+from scc.uinput import Keys, Scans
+from scc.lib import xwrappers as X
+from ctypes.util import find_library
+
+import ctypes, logging
+log = logging.getLogger("TextInjector")
+
+SHIFT = Keys.KEY_LEFTSHIFT
+ALTGR = Keys.KEY_RIGHTALT
+
+# X keycode = evdev keycode + 8
+X_KEYCODE_OFFSET = 8
+NO_SYMBOL = 0
+
+# Which modifiers are needed to get keysym at given index in keysym list
+# returned by XGetKeyboardMapping, for first and second keyboard group
+LEVELS = (
+	( (0, ()), (1, (SHIFT,)), (4, (ALTGR,)), (5, (ALTGR, SHIFT)) ),
+	( (2, ()), (3, (SHIFT,)) ),
+)
+
+# Characters typed by same key on any layout
+SPECIAL = { "\n" : Keys.KEY_ENTER, "\t" : Keys.KEY_TAB }
+
+# Keysyms with no unicode equivalent, but needed for SPECIAL characters
+XK_RETURN, XK_TAB = 0xff0d, 0xff09
+
+_libxkbcommon = None
+
+
+def keysym_to_unicode(keysym):
+	""" Returns character produced by keysym or None """
+	global _libxkbcommon
+	if keysym == XK_RETURN:
+		return "\n"
+	if keysym == XK_TAB:
+		return "\t"
+	if 0x20 <= keysym <= 0x7e or 0xa0 <= keysym <= 0xff:
+		# Latin-1 keysyms are same as unicode codepoints
+		return unichr(keysym)
+	if keysym & 0xff000000 == 0x01000000:
+		# Unicode keysyms
+		return unichr(keysym & 0x00ffffff)
+	# Legacy keysyms have to be looked up in table
+	if _libxkbcommon is None:
+		try:
+			_libxkbcommon = ctypes.CDLL(find_library("xkbcommon") or "libxkbcommon.so.0")
+			_libxkbcommon.xkb_keysym_to_utf32.argtypes = [ ctypes.c_uint32 ]
+			_libxkbcommon.xkb_keysym_to_utf32.restype = ctypes.c_uint32
+		except OSError:
+			log.warning("libxkbcommon not found, only latin1 and unicode keysyms are supported")
+			_libxkbcommon = False
+	if _libxkbcommon:
+		cp = _libxkbcommon.xkb_keysym_to_utf32(keysym)
+		if cp:
+			return unichr(cp)
+	return None
+
+
+def unicode_to_keysym(char):
+	""" Returns keysym that produces character """
+	cp = ord(char)
+	if 0x20 <= cp <= 0x7e or 0xa0 <= cp <= 0xff:
+		return cp
+	return 0x01000000 | cp
+
+
+class KeyboardLayout(object):
+	"""
+	Maps characters to (key, modifiers) tuples.
+	"""
+	
+	def __init__(self, chars, spare=None):
+		self.chars = chars
+		# Key that has no keysym assigned, used for characters not in layout
+		self.spare = spare
+	
+	
+	def lookup(self, char):
+		""" Returns (key, modifiers) or None if character is not in layout """
+		if char in SPECIAL:
+			return SPECIAL[char], ()
+		return self.chars.get(char)
+	
+	
+	@staticmethod
+	def default():
+		""" Returns US layout """
+		chars = {}
+		rows = (
+			"`~1!2@3#4$5%6^7&8*9(0)-_=+[{]}\\|;:'\",<.>/?  ",
+			( "GRAVE", 1, 2, 3, 4, 5, 6, 7, 8, 9, 0, "MINUS", "EQUAL",
+			"LEFTBRACE", "RIGHTBRACE", "BACKSLASH", "SEMICOLON", "APOSTROPHE",
+			"COMMA", "DOT", "SLASH", "SPACE"),
+		)
+		for i, name in enumerate(rows[1]):
+			key = getattr(Keys, "KEY_%s" % (name,))
+			chars.setdefault(rows[0][i * 2], (key, ()))
+			chars.setdefault(rows[0][i * 2 + 1], (key, (SHIFT,)))
+		for letter in "abcdefghijklmnopqrstuvwxyz":
+			key = getattr(Keys, "KEY_%s" % (letter.upper(),))
+			chars[letter] = key, ()
+			chars[letter.upper()] = key, (SHIFT,)
+		return KeyboardLayout(chars)
+	
+	
+	@staticmethod
+	def from_x(dpy):
+		""" Returns layout currently used by X server """
+		group = min(X.get_xkb_state(dpy).group, len(LEVELS) - 1)
+		keys = { int(k) : k for k in Scans }
+		chars, spare = {}, None
+		for keycode, keysyms in sorted(X.get_keyboard_mapping(dpy).items()):
+			key = keys.get(keycode - X_KEYCODE_OFFSET)
+			if key is None:
+				# Can't be pressed on emulated keyboard
+				continue
+			if not any(keysyms):
+				spare = spare or key
+				continue
+			for index, modifiers in LEVELS[group]:
+				if index < len(keysyms) and keysyms[index] != NO_SYMBOL:
+					char = keysym_to_unicode(keysyms[index])
+					if char is not None and (char not in chars
+								or len(modifiers) < len(chars[char][1])):
+						chars[char] = key, modifiers
+		return KeyboardLayout(chars, spare)
+
+
+class TextInjector(object):
+	BATCH_SIZE = 16			# How many characters are typed in one go
+	REMAP_DELAY = 0.05		# Time for clients to notice keyboard mapping change
+	
+	def __init__(self, mapper):
+		self.mapper = mapper
+		self._queue = []		# list of (char, delay, callback)
+		self._running = False
+		self._remapped = False
+		self._layout = None
+	
+	
+	def get_layout(self):
+		"""
+		Returns current keyboard layout. Layout is loaded from X server every
+		time typing starts, so change of layout is noticed.
+		"""
+		if self._layout is None:
+			dpy = self.mapper.get_xdisplay()
+			if dpy:
+				self._layout = KeyboardLayout.from_x(dpy)
+			else:
+				self._layout = KeyboardLayout.default()
+		return self._layout
+	
+	
+	def type(self, text, delay=0, callback=None):
+		"""
+		Types text. If 'delay' is set, waits for that many seconds
+		after each character.
+		
+		If set, callback is called as callback(mapper) after all
+		characters are sent to keyboard.
+		"""
+		if text:
+			self._queue += [ (char, delay, None) for char in text[:-1] ]
+			self._queue.append((text[-1], delay, callback))
+		elif callback:
+			# Nothing to type, but callback has to wait for text
+			# queued before
+			self._queue.append((None, delay, callback))
+		if not self._running:
+			self._running = True
+			self._layout = None
+			self._next(self.mapper)
+	
+	
+	def _next(self, mapper):
+		""" Types next batch of characters """
+		layout = self.get_layout()
+		events, delay, callbacks = [], 0, []
+		while self._queue and len(events) < TextInjector.BATCH_SIZE * 4:
+			char, delay, callback = self._queue[0]
+			if char is None:
+				self._queue.pop(0)
+				callbacks.append(callback)
+				continue
+			k = layout.lookup(char)
+			if k is None:
+				if events or callbacks:
+					# Type what's already collected first. If that includes
+					# remapped key, clients have to process it before key
+					# is remapped again.
+					if self._remapped:
+						delay = max(delay, TextInjector.REMAP_DELAY)
+					break
+				if self._remap(char):
+					mapper.schedule(TextInjector.REMAP_DELAY, self._next)
+					return
+				log.warning("Can't type '%s', character is not in keyboard layout", char)
+				self._queue.pop(0)
+				if callback:
+					callbacks.append(callback)
+				continue
+			key, modifiers = k
+			events += [ (m, 1) for m in modifiers ]
+			events += [ (key, 1), (key, 0) ]
+			events += [ (m, 0) for m in reversed(modifiers) ]
+			self._queue.pop(0)
+			if callback:
+				callbacks.append(callback)
+			if delay:
+				break
+		
+		mapper.keyboard.keyEvents(events)
+		for callback in callbacks:
+			callback(mapper)
+		if self._queue:
+			mapper.schedule(delay, self._next)
+		elif self._remapped:
+			mapper.schedule(TextInjector.REMAP_DELAY, self._restore)
+		else:
+			self._running = False
+	
+	
+	def _remap(self, char):
+		"""
+		Assigns character to spare key of current layout.
+		Returns False if that's not possible.
+		"""
+		dpy = self.mapper.get_xdisplay()
+		if not dpy or self._layout.spare is None:
+			return False
+		self._set_keysym(dpy, self._layout.spare, unicode_to_keysym(char))
+		self._layout.chars[char] = self._layout.spare, ()
+		self._remapped = char
+		return True
+	
+	
+	def _restore(self, mapper):
+		""" Removes keysym assigned by _remap """
+		dpy = mapper.get_xdisplay()
+		if dpy and self._remapped:
+			self._set_keysym(dpy, self._layout.spare, NO_SYMBOL)
+		self._remapped = False
+		self._running = False
+		if self._queue:
+			# Something new was queued in meantime
+			self.type("")
+	
+	
+	def _set_keysym(self, dpy, key, keysym):
+		if self._remapped:
+			# Only one character can be assigned to spare key at time
+			del self._layout.chars[self._remapped]
+		keysyms = (X.KeySym * 1)(keysym)
+		X.change_keyboard_mapping(dpy, int(key) + X_KEYCODE_OFFSET, 1, keysyms, 1)
+		X.sync(dpy, False)
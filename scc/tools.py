@@ -11,8 +11,9 @@ from scc.paths import get_menuicons_path, get_default_menuicons_path
 from scc.paths import get_profiles_path, get_default_profiles_path
 from scc.paths import get_menus_path, get_default_menus_path
 from scc.paths import get_button_images_path
+from scc.lib.inotify import DirectoryIndex
 from math import pi as PI, sin, cos, atan2, sqrt
-import os, sys, ctypes, imp, shlex, gettext, logging
+import os, sys, ctypes, imp, shlex, gettext, threading, logging
 
 HAVE_POSIX1E = False
 try:
@@ -192,13 +193,47 @@ def find_profile(name):
 	Returns None if profile cannot be found.
 	"""
 	filename = "%s.sccprofile" % (name,)
-	for p in (get_profiles_path(), get_default_profiles_path()):
-		path = os.path.join(p, filename)
-		if os.path.exists(path):
-			return path
+	return _find_file(filename, (get_profiles_path(), get_default_profiles_path()))
+
+
+def _find_file(filename, paths):
+	"""
+	Returns full path to first of paths that contains filename, or None.
+	Uses file index, so no filesystem access is done for known directories.
+	"""
+	if os.path.isabs(filename) or os.path.normpath(filename) != filename:
+		# Not something that can be found in index
+		for p in paths:
+			path = os.path.join(p, filename)
+			if os.path.exists(path):
+				return path
+		return None
+	index = get_file_index()
+	index.refresh()
+	for p in paths:
+		if filename in index.get_files(p, False):
+			return os.path.join(p, filename)
 	return None
 
 
+_file_index = None
+_file_index_lock = threading.Lock()
+_icon_cache = {}
+_icon_cache_serial = -1
+
+def get_file_index():
+	"""
+	Returns DirectoryIndex instance shared by everything in process.
+	Index is created on first call. Safe to call from any thread.
+	"""
+	global _file_index
+	if _file_index is None:
+		with _file_index_lock:
+			if _file_index is None:
+				_file_index = DirectoryIndex()
+	return _file_index
+
+
 def find_icon(name, prefer_bw=False, paths=None, extensions=("png", "svg")):
 	"""
 	Returns (filename, has_colors) for specified icon name.
@@ -220,6 +255,26 @@ def find_icon(name, prefer_bw=False, paths=None, extensions=("png", "svg")):
 		paths = get_default_menuicons_path(), get_menuicons_path()
 	if name.endswith(".bw"):
 		name = name[0:-3]
+	if os.path.isabs(name) or os.path.normpath(name) != name:
+		# Not something that can be found in index
+		return _find_icon(name, prefer_bw, paths, extensions,
+			lambda p, filename: os.path.exists(os.path.join(p, filename)))
+	
+	global _icon_cache, _icon_cache_serial
+	index = get_file_index()
+	serial = index.refresh()
+	if serial != _icon_cache_serial:
+		_icon_cache, _icon_cache_serial = {}, serial
+	key = name, prefer_bw, tuple(paths), tuple(extensions)
+	if key not in _icon_cache:
+		files = { p : index.get_files(p, False) for p in paths }
+		_icon_cache[key] = _find_icon(name, prefer_bw, paths, extensions,
+			lambda p, filename: filename in files[p])
+	return _icon_cache[key]
+
+
+def _find_icon(name, prefer_bw, paths, extensions, exists):
+	""" Does actual work for find_icon. exists(path, filename) is called to check for file """
 	for extension in extensions:
 		gray_filename = "%s.bw.%s" % (name, extension)
 		colors_filename = "%s.%s" % (name, extension)
@@ -227,15 +282,15 @@ def find_icon(name, prefer_bw=False, paths=None, extensions=("png", "svg")):
 		for p in paths:
 			# Check grayscale
 			if gray is None:
-				path = os.path.join(p, gray_filename)
-				if os.path.exists(path):
+				if exists(p, gray_filename):
+					path = os.path.join(p, gray_filename)
 					if prefer_bw:
 						return path, False
 					gray = path
 			# Check colors
 			if colors is None:
-				path = os.path.join(p, colors_filename)
-				if os.path.exists(path):
+				if exists(p, colors_filename):
+					path = os.path.join(p, colors_filename)
 					if not prefer_bw:
 						return path, True
 					colors = path
@@ -257,7 +312,7 @@ def menu_is_default(name):
 	Returns True if named menu exists in default_menus directory, even
 	if it is overrided by menu in user config directory.
 	"""
-	return os.path.exists(os.path.join(get_default_menus_path(), name))
+	return _find_file(name, (get_default_menus_path(),)) is not None
 
 
 def find_menu(name):
@@ -268,11 +323,57 @@ def find_menu(name):
 	
 	Returns None if menu cannot be found.
 	"""
-	for p in (get_menus_path(), get_default_menus_path()):
-		path = os.path.join(p, name)
-		if os.path.exists(path):
-			return path
-	return None
+	return _find_file(name, (get_menus_path(), get_default_menus_path()))
+
+
+_list_cache = {}
+_list_cache_serial = -1
+
+def get_profile_list():
+	"""
+	Returns dict of { name : (filename, is_override, mtime) } for every
+	available profile, where is_override is True if profile in user config
+	directory replaces one from default_profiles.
+	
+	Result is cached until something in profile directories changes.
+	"""
+	return _list_files(get_profiles_path(), get_default_profiles_path(), ".sccprofile", True)
+
+
+def get_menu_list():
+	"""
+	As get_profile_list, but for menus. Name is filename of menu, including
+	'.menu' extension, as used by find_menu.
+	"""
+	return _list_files(get_menus_path(), get_default_menus_path(), ".menu", False)
+
+
+def _list_files(user_path, default_path, extension, strip_extension):
+	""" Does actual work for get_profile_list and get_menu_list """
+	global _list_cache, _list_cache_serial
+	index = get_file_index()
+	files = index.get_files(user_path), index.get_files(default_path, False)
+	serial = index.refresh()
+	if serial != _list_cache_serial or index.fileno() is None:
+		# Without inotify, mtimes cannot be cached
+		_list_cache, _list_cache_serial = {}, serial
+	key = user_path, default_path, extension
+	if key not in _list_cache:
+		rv = {}
+		user_files, default_files = files
+		for path, names in ((default_path, default_files), (user_path, user_files)):
+			for x in names:
+				if x.endswith(extension) and not x.startswith(".") and os.path.sep not in x:
+					filename = os.path.join(path, x)
+					try:
+						mtime = os.stat(filename).st_mtime
+					except OSError:
+						# Removed in meantime
+						continue
+					name = x[0:-len(extension)] if strip_extension else x
+					rv[name] = filename, path == user_path and x in default_files, mtime
+		_list_cache[key] = rv
+	return _list_cache[key]
 
 
 def find_controller_icon(name):
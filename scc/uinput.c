@@ -31,13 +31,19 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/prctl.h>
 
 #pragma GCC diagnostic ignored "-Wunused-result"
-#define UNPUT_MODULE_VERSION 9
+#define UNPUT_MODULE_VERSION 11
 #define MAX_FF_EVENTS 4
 
 #define INFINITE_RUMBLE		10000		// Not really infinite, but longer than controller can handle
+#define MACRO_DEVICES		3			// keyboard, mouse, gamepad
+#define MACRO_BUFFER		64			// events written to one device in single write()
 
 struct feedback_effect {
 	bool in_use;
@@ -247,6 +253,32 @@ void uinput_syn(int fd)
 	write(fd, &ev, sizeof(ev));
 }
 
+/**
+ * Generates 'count' key events, each followed by syn event,
+ * using as few write() calls as possible.
+ */
+void uinput_keys(int fd, int count, __u16 * keys, __s32 * values)
+{
+	struct input_event ev[128];
+	int i, n = 0;
+
+	memset(&ev, 0, sizeof(ev));
+	for (i = 0; i < count; i++) {
+		ev[n].type = EV_KEY;
+		ev[n].code = keys[i];
+		ev[n].value = values[i];
+		n++;
+		ev[n].type = EV_SYN;
+		ev[n].code = SYN_REPORT;
+		ev[n].value = 0;
+		n++;
+		if ((n == 128) || (i == count - 1)) {
+			write(fd, ev, sizeof(struct input_event) * n);
+			n = 0;
+		}
+	}
+}
+
 // #define RUMBLE_DEBUG(...) do { printf(__VA_ARGS__); } while (0)
 #define RUMBLE_DEBUG(...) do { } while (0)
 
@@ -434,3 +466,367 @@ void uinput_destroy(int fd)
 	ioctl(fd, UI_DEV_DESTROY);
 	close(fd);
 }
+
+/**
+ * Macro player.
+ *
+ * Plays scripts compiled from macros (see scc/macros.py) on background
+ * thread, with timing independent of daemon's mainloop. Each script is
+ * list of events with time relative to start of script. When script
+ * starts, finishes or is canceled, notification is queued and pipe is
+ * made readable, so Python side knows it should call macro_player_pop.
+ */
+
+struct macro_event {
+	__u32 time;		// microseconds since start of script
+	__u16 device;	// index into 'fds' passed to macro_play
+	__u16 type;
+	__u16 code;
+	__s32 value;
+};
+
+struct macro_notification {
+	__s32 id;
+	__s32 what;
+};
+
+#define MACRO_STARTED		1
+#define MACRO_FINISHED		2
+#define MACRO_CANCELED		3
+
+struct macro_playback {
+	int id;
+	int fds[MACRO_DEVICES];
+	int count;
+	int index;					// next event to play
+	__u32 length;				// time from start of script to its end
+	bool repeat;
+	bool started;
+	struct timespec start;
+	struct macro_event* events;
+	struct macro_playback* next;
+};
+
+struct macro_queued_notification {
+	struct macro_notification n;
+	struct macro_queued_notification* next;
+};
+
+struct macro_player {
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	int pipe[2];
+	int next_id;
+	bool exit;
+	struct macro_playback* playing;
+	struct macro_queued_notification* queue;
+	struct macro_queued_notification* queue_tail;
+};
+
+static void timespec_add(struct timespec* ts, __u32 us) {
+	ts->tv_sec += us / 1000000;
+	ts->tv_nsec += (us % 1000000) * 1000;
+	if (ts->tv_nsec >= 1000000000) {
+		ts->tv_sec ++;
+		ts->tv_nsec -= 1000000000;
+	}
+}
+
+static bool timespec_before(const struct timespec* a, const struct timespec* b) {
+	if (a->tv_sec == b->tv_sec)
+		return a->tv_nsec < b->tv_nsec;
+	return a->tv_sec < b->tv_sec;
+}
+
+/** Has to be called with lock held */
+static void macro_notify(struct macro_player* p, int id, int what) {
+	char wakeup = 0;
+	struct macro_queued_notification* q = malloc(sizeof(struct macro_queued_notification));
+	if (q == NULL)
+		return;
+	q->n.id = id;
+	q->n.what = what;
+	q->next = NULL;
+	if (p->queue == NULL) {
+		// Pipe is written only when queue becomes non-empty. If this write
+		// fails because pipe is full, reader is woken up anyway.
+		p->queue = q;
+		write(p->pipe[1], &wakeup, 1);
+	} else {
+		p->queue_tail->next = q;
+	}
+	p->queue_tail = q;
+}
+
+/** Writes events, grouping them by device and adding syn event after every one */
+static void macro_write(struct macro_playback* pb, int from, int to) {
+	struct input_event buffer[MACRO_BUFFER];
+	int d, i, n;
+	
+	memset(buffer, 0, sizeof(buffer));
+	for (d = 0; d < MACRO_DEVICES; d++) {
+		if (pb->fds[d] < 0) continue;
+		n = 0;
+		for (i = from; i < to; i++) {
+			if (pb->events[i].device != d) continue;
+			buffer[n].type = pb->events[i].type;
+			buffer[n].code = pb->events[i].code;
+			buffer[n].value = pb->events[i].value;
+			n++;
+			if (pb->events[i].type == EV_KEY) {
+				buffer[n].type = EV_SYN;
+				buffer[n].code = SYN_REPORT;
+				buffer[n].value = 0;
+				n++;
+			}
+			if (n >= MACRO_BUFFER - 2) {
+				write(pb->fds[d], buffer, sizeof(struct input_event) * n);
+				n = 0;
+			}
+		}
+		if (n > 0) {
+			if (buffer[n - 1].type != EV_SYN) {
+				buffer[n].type = EV_SYN;
+				buffer[n].code = SYN_REPORT;
+				buffer[n].value = 0;
+				n++;
+			}
+			write(pb->fds[d], buffer, sizeof(struct input_event) * n);
+		}
+	}
+}
+
+/** Releases every key that was pressed and not released by played part of script */
+static void macro_release_keys(struct macro_playback* pb) {
+	int i, j;
+	for (i = pb->index - 1; i >= 0; i--) {
+		struct macro_event* e = &pb->events[i];
+		if ((e->type != EV_KEY) || (e->value == 0) || (pb->fds[e->device] < 0))
+			continue;
+		for (j = i + 1; j < pb->index; j++) {
+			if ((pb->events[j].type == EV_KEY) && (pb->events[j].code == e->code)
+						&& (pb->events[j].device == e->device))
+				break;
+		}
+		if (j == pb->index) {
+			uinput_key(pb->fds[e->device], e->code, 0);
+			uinput_syn(pb->fds[e->device]);
+		}
+	}
+}
+
+/**
+ * Plays everything that is due. Returns false if playback is finished,
+ * otherwise stores time when it should be called again to 'wakeup'.
+ */
+static bool macro_advance(struct macro_playback* pb, const struct timespec* now,
+			struct timespec* wakeup) {
+	while (true) {
+		int from = pb->index;
+		while (pb->index < pb->count) {
+			*wakeup = pb->start;
+			timespec_add(wakeup, pb->events[pb->index].time);
+			if (timespec_before(now, wakeup))
+				break;
+			pb->index++;
+		}
+		if (pb->index > from)
+			macro_write(pb, from, pb->index);
+		if (pb->index < pb->count)
+			return true;
+		
+		*wakeup = pb->start;
+		timespec_add(wakeup, pb->length);
+		if (timespec_before(now, wakeup))
+			return true;
+		if (!pb->repeat || (pb->length == 0))
+			return false;
+		// Repeating
+		pb->start = *wakeup;
+		pb->index = 0;
+	}
+}
+
+static void* macro_player_thread(void* arg) {
+	struct macro_player* p = (struct macro_player*)arg;
+	struct macro_playback** pp;
+	struct timespec now, wakeup, next;
+	bool has_next;
+	
+	// Default slack of 50us would be most of error
+	prctl(PR_SET_TIMERSLACK, 1, 0, 0, 0);
+	pthread_mutex_lock(&p->lock);
+	while (!p->exit) {
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		has_next = false;
+		pp = &p->playing;
+		while (*pp != NULL) {
+			struct macro_playback* pb = *pp;
+			if (!pb->started) {
+				pb->started = true;
+				macro_notify(p, pb->id, MACRO_STARTED);
+			}
+			if (macro_advance(pb, &now, &wakeup)) {
+				if (!has_next || timespec_before(&wakeup, &next))
+					next = wakeup;
+				has_next = true;
+				pp = &pb->next;
+			} else {
+				*pp = pb->next;
+				macro_notify(p, pb->id, MACRO_FINISHED);
+				free(pb->events);
+				free(pb);
+			}
+		}
+		if (has_next)
+			pthread_cond_timedwait(&p->cond, &p->lock, &next);
+		else
+			pthread_cond_wait(&p->cond, &p->lock);
+	}
+	pthread_mutex_unlock(&p->lock);
+	return NULL;
+}
+
+/** Returns NULL on failure */
+struct macro_player* macro_player_new(void) {
+	pthread_condattr_t attr;
+	struct macro_player* p = malloc(sizeof(struct macro_player));
+	if (p == NULL)
+		return NULL;
+	memset(p, 0, sizeof(struct macro_player));
+	if (pipe(p->pipe) != 0) {
+		free(p);
+		return NULL;
+	}
+	fcntl(p->pipe[0], F_SETFD, FD_CLOEXEC);
+	fcntl(p->pipe[1], F_SETFD, FD_CLOEXEC);
+	fcntl(p->pipe[0], F_SETFL, O_NONBLOCK);
+	fcntl(p->pipe[1], F_SETFL, O_NONBLOCK);
+	pthread_mutex_init(&p->lock, NULL);
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&p->cond, &attr);
+	pthread_condattr_destroy(&attr);
+	if (pthread_create(&p->thread, NULL, macro_player_thread, p) != 0) {
+		close(p->pipe[0]);
+		close(p->pipe[1]);
+		free(p);
+		return NULL;
+	}
+	return p;
+}
+
+/**
+ * Returns descriptor that becomes readable when there are notifications
+ * to pop. Data read from it have no meaning.
+ */
+int macro_player_fd(struct macro_player* p) {
+	return p->pipe[0];
+}
+
+/** Stores oldest queued notification to 'n'. Returns false if queue is empty */
+bool macro_player_pop(struct macro_player* p, struct macro_notification* n) {
+	struct macro_queued_notification* q;
+	pthread_mutex_lock(&p->lock);
+	q = p->queue;
+	if (q != NULL) {
+		*n = q->n;
+		p->queue = q->next;
+		free(q);
+	}
+	pthread_mutex_unlock(&p->lock);
+	return q != NULL;
+}
+
+/**
+ * Starts playing script. Events are copied, so caller can free them.
+ * Returns playback id or -1 on failure.
+ */
+int macro_play(struct macro_player* p, int* fds, int count,
+			struct macro_event* events, __u32 length, bool repeat) {
+	struct macro_playback* pb = malloc(sizeof(struct macro_playback));
+	if (pb == NULL)
+		return -1;
+	memset(pb, 0, sizeof(struct macro_playback));
+	pb->events = malloc(sizeof(struct macro_event) * (count > 0 ? count : 1));
+	if (pb->events == NULL) {
+		free(pb);
+		return -1;
+	}
+	memcpy(pb->events, events, sizeof(struct macro_event) * count);
+	memcpy(pb->fds, fds, sizeof(int) * MACRO_DEVICES);
+	pb->count = count;
+	pb->length = length;
+	pb->repeat = repeat;
+	clock_gettime(CLOCK_MONOTONIC, &pb->start);
+	
+	pthread_mutex_lock(&p->lock);
+	pb->id = ++p->next_id;
+	pb->next = p->playing;
+	p->playing = pb;
+	pthread_cond_signal(&p->cond);
+	pthread_mutex_unlock(&p->lock);
+	return pb->id;
+}
+
+/**
+ * Changes whether playback should start again once it reaches end.
+ * Clearing 'repeat' lets playback finish at end of current repetition.
+ * Returns false if playback already finished.
+ */
+bool macro_set_repeat(struct macro_player* p, int id, bool repeat) {
+	struct macro_playback* pb;
+	bool found = false;
+	pthread_mutex_lock(&p->lock);
+	for (pb = p->playing; pb != NULL; pb = pb->next) {
+		if (pb->id == id) {
+			pb->repeat = repeat;
+			found = true;
+		}
+	}
+	pthread_mutex_unlock(&p->lock);
+	return found;
+}
+
+/** Stops playback immediately, releasing all keys it's holding. id -1 cancels everything */
+void macro_cancel(struct macro_player* p, int id) {
+	struct macro_playback** pp;
+	pthread_mutex_lock(&p->lock);
+	pp = &p->playing;
+	while (*pp != NULL) {
+		struct macro_playback* pb = *pp;
+		if ((id == -1) || (pb->id == id)) {
+			*pp = pb->next;
+			macro_release_keys(pb);
+			macro_notify(p, pb->id, MACRO_CANCELED);
+			free(pb->events);
+			free(pb);
+		} else {
+			pp = &pb->next;
+		}
+	}
+	pthread_cond_signal(&p->cond);
+	pthread_mutex_unlock(&p->lock);
+}
+
+/** Stops thread, cancels everything that's still playing and frees player */
+void macro_player_free(struct macro_player* p) {
+	struct macro_queued_notification* q;
+	macro_cancel(p, -1);
+	pthread_mutex_lock(&p->lock);
+	p->exit = true;
+	pthread_cond_signal(&p->cond);
+	pthread_mutex_unlock(&p->lock);
+	pthread_join(p->thread, NULL);
+	while (p->queue != NULL) {
+		q = p->queue;
+		p->queue = q->next;
+		free(q);
+	}
+	close(p->pipe[0]);
+	close(p->pipe[1]);
+	pthread_cond_destroy(&p->cond);
+	pthread_mutex_destroy(&p->lock);
+	free(p);
+}
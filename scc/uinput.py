@@ -22,7 +22,7 @@
 # OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 # THE SOFTWARE.
 
-import os, ctypes, time
+import os, ctypes, time, json
 from ctypes import Structure, POINTER, c_bool, c_int16, c_uint16, c_int32, byref
 from math import pi, copysign, sqrt
 from scc.lib.libusb1 import timeval
@@ -30,7 +30,7 @@ from scc.tools import find_library
 from scc.cheader import defines
 from scc.lib import IntEnum
 
-UNPUT_MODULE_VERSION = 9
+UNPUT_MODULE_VERSION = 11
 
 # Get All defines from linux headers
 if os.path.exists('/usr/include/linux/input-event-codes.h'):
@@ -183,6 +183,21 @@ class InputEvent(ctypes.Structure):
 		('value', c_int32)
 	]
 
+class MacroEvent(ctypes.Structure):
+	_fields_ = [
+		('time', ctypes.c_uint32),
+		('device', c_uint16),
+		('type', c_uint16),
+		('code', c_uint16),
+		('value', c_int32)
+	]
+
+class MacroNotification(ctypes.Structure):
+	_fields_ = [
+		('id', c_int32),
+		('what', c_int32)
+	]
+
 class FeedbackEvent(ctypes.Structure):
 	_fields_ = [
 		('in_use', c_bool),
@@ -204,10 +219,14 @@ class UInput(object):
 
 	See Gamepad, Mouse, Keyboard for examples
 	"""
+	
+	# Descriptors of devices created by another process, see inherit()
+	_inherited = {}		# signature -> list of descriptors
 
 
 	def __init__(self, vendor, product, version, name, keys, axes, rels, keyboard=False, rumble=False):
 		self._lib = None
+		self._detached = False
 		self._k = keys
 		self.name = name
 		if not axes or len(axes) == 0:
@@ -248,6 +267,14 @@ class UInput(object):
 		c_rumble = ctypes.c_int(MAX_FEEDBACK_EFFECTS if rumble else 0)
 		c_name = ctypes.c_char_p(name.encode("utf-8"))
 		
+		self.signature = json.dumps([ vendor, product, version, name,
+			[ int(x) for x in self._k ], [ list(x) for x in axes or [] ],
+			[ int(x) for x in self._r ], bool(keyboard), bool(rumble) ])
+		if UInput._inherited.get(self.signature):
+			# Same device was already created by previous daemon instance
+			self._fd = UInput._inherited[self.signature].pop(0)
+			return
+		
 		self._fd = self._lib.uinput_init(ctypes.c_int(len(self._k)),
 										 c_k,
 										 ctypes.c_int(len(self._a)),
@@ -270,6 +297,37 @@ class UInput(object):
 
 	def getDescriptor(self):
 		return self._fd
+	
+	
+	def detach(self):
+		"""
+		Returns device descriptor and stops managing it, so device is
+		not destroyed when this object is. Used to pass device to another
+		process, which then calls inherit().
+		"""
+		self._detached = True
+		return self._fd
+	
+	
+	@staticmethod
+	def inherit(signature, fd):
+		"""
+		Stores descriptor of device created by another process. Next UInput
+		instance created with same parameters will use it instead of
+		creating new device.
+		"""
+		UInput._inherited.setdefault(signature, []).append(fd)
+	
+	
+	@staticmethod
+	def destroy_inherited():
+		""" Destroys all inherited devices that were not used """
+		inherited, UInput._inherited = UInput._inherited, {}
+		lib = None
+		for fds in inherited.values():
+			for fd in fds:
+				lib = lib or find_library("libuinput")
+				lib.uinput_destroy(fd)
 
 
 	def keyEvent(self, key, val):
@@ -284,6 +342,20 @@ class UInput(object):
 							 ctypes.c_int32(val))
 
 
+	def keyEvents(self, events):
+		"""
+		Generates multiple key events, each followed by syn event,
+		in single write.
+
+		@param list events		list of (key, value) tuples
+		"""
+		if len(events):
+			keys, values = zip(*events)
+			self._lib.uinput_keys(self._fd, len(events),
+							(ctypes.c_uint16 * len(events))(*keys),
+							(ctypes.c_int32 * len(events))(*values))
+
+
 	def axisEvent(self, axis, val):
 		"""
 		Generate a abs event (joystick/pad axes)
@@ -354,7 +426,7 @@ class UInput(object):
 		return None
 
 	def __del__(self):
-		if self._lib:
+		if self._lib and not self._detached:
 			self._lib.uinput_destroy(self._fd)
 
 
@@ -577,6 +649,127 @@ class Keyboard(UInput):
 			self._pressed -= set(rem)
 
 
+class MacroPlayer(object):
+	"""
+	Plays macros compiled to list of events on background thread of
+	libuinput, with precise timing that doesn't depend on mainloop.
+	
+	Script is list of (time, device, key, value) tuples, where time is in
+	microseconds since start of script and device is one of
+	MacroPlayer.KEYBOARD, MOUSE or GAMEPAD.
+	
+	Callback passed to play() is called from poller as
+	callback(id, what), where what is one of STARTED, FINISHED or CANCELED.
+	"""
+	KEYBOARD, MOUSE, GAMEPAD = 0, 1, 2
+	STARTED, FINISHED, CANCELED = 1, 2, 3
+	
+	def __init__(self, poller, keyboard, mouse, gamepad):
+		self._lib = find_library("libuinput")
+		self._lib.macro_player_new.restype = ctypes.c_void_p
+		self._lib.macro_player_fd.argtypes = [ ctypes.c_void_p ]
+		self._lib.macro_play.argtypes = [ ctypes.c_void_p, POINTER(ctypes.c_int),
+			ctypes.c_int, POINTER(MacroEvent), ctypes.c_uint32, c_bool ]
+		self._lib.macro_set_repeat.argtypes = [ ctypes.c_void_p, ctypes.c_int, c_bool ]
+		self._lib.macro_set_repeat.restype = c_bool
+		self._lib.macro_cancel.argtypes = [ ctypes.c_void_p, ctypes.c_int ]
+		self._lib.macro_player_pop.argtypes = [ ctypes.c_void_p, POINTER(MacroNotification) ]
+		self._lib.macro_player_pop.restype = c_bool
+		self._lib.macro_player_free.argtypes = [ ctypes.c_void_p ]
+		self._player = self._lib.macro_player_new()
+		if not self._player:
+			raise OSError("Failed to start macro player")
+		self._fds = (ctypes.c_int * 3)(*[
+			dev.getDescriptor() if hasattr(dev, "getDescriptor") else -1
+			for dev in (keyboard, mouse, gamepad) ])
+		self._callbacks = {}
+		self._notification = MacroNotification()
+		self._fd = self._lib.macro_player_fd(self._player)
+		self._poller = poller
+		poller.register(self._fd, poller.POLLIN, self._on_notification)
+	
+	
+	@staticmethod
+	def compile(script):
+		"""
+		Converts script to array that can be passed to play().
+		Keyboard keys are preceded by scan events, as with Keyboard.pressEvent
+		"""
+		events = []
+		for time, device, key, value in script:
+			if device == MacroPlayer.KEYBOARD and key in Scans:
+				events.append((time, device, CHEAD['EV_MSC'], CHEAD['MSC_SCAN'], Scans[key]))
+			events.append((time, device, CHEAD['EV_KEY'], key, value))
+		return (MacroEvent * len(events))(*events)
+	
+	
+	def play(self, events, length, repeat, callback):
+		"""
+		Starts playing events compiled by compile(). 'length' is time in
+		microseconds from start of script to its end. If 'repeat' is set,
+		script is played again and again until set_repeat(id, False) is called.
+		
+		Returns playback id or None on failure.
+		"""
+		id = self._lib.macro_play(self._player, self._fds, len(events),
+			events, length, repeat)
+		if id < 0:
+			return None
+		self._callbacks[id] = callback
+		return id
+	
+	
+	def set_repeat(self, id, repeat):
+		"""
+		Changes whether playback starts again once it reaches end.
+		Clearing 'repeat' lets it finish at end of current repetition.
+		
+		Returns False if playback is already finished, even if its callback
+		was not called yet, or if player was closed.
+		"""
+		if not self._player:
+			return False
+		return self._lib.macro_set_repeat(self._player, id, repeat)
+	
+	
+	def cancel(self, id=-1):
+		"""
+		Stops playback immediately, releasing all keys pressed by it.
+		Without id, stops everything.
+		"""
+		if self._player:
+			self._lib.macro_cancel(self._player, id)
+	
+	
+	def close(self):
+		"""
+		Cancels everything that's still playing and stops player thread.
+		Player can't be used after this.
+		"""
+		if self._player:
+			self._poller.unregister(self._fd)
+			self._lib.macro_player_free(self._player)
+			self._player = None
+			self._callbacks = {}
+	
+	
+	def _on_notification(self, *a):
+		# Pipe only signals that there is something in queue
+		try:
+			while os.read(self._fd, 1024):
+				pass
+		except OSError:
+			pass
+		n = self._notification
+		while self._player and self._lib.macro_player_pop(self._player, byref(n)):
+			if n.what == MacroPlayer.STARTED:
+				cb = self._callbacks.get(n.id)
+			else:
+				cb = self._callbacks.pop(n.id, None)
+			if cb:
+				cb(n.id, n.what)
+
+
 class Dummy(object):
 	""" Fake uinput device that does nothing, but has all required methods """
 	def __init__(self, *a, **b):
@@ -586,6 +779,7 @@ class Dummy(object):
 		pass
 	
 	axisEvent = keyEvent
+	keyEvents = keyEvent
 	relEvent = keyEvent
 	scanEvent = keyEvent
 	synEvent = keyEvent
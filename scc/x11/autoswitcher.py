@@ -27,7 +27,7 @@ class AutoSwitcher(object):
 		self.dpy = X.open_display(os.environ["DISPLAY"])
 		self.lock = threading.Lock()
 		self.thread = threading.Thread(target=self.connect_daemon)
-		self.config = Config()
+		self.config = Config.get_shared()
 		self.mapper = Mapper(None, None, keyboard=None, mouse=None, gamepad=None)
 		self.mapper.set_special_actions_handler(self)
 		self.enabled = False
@@ -114,7 +114,7 @@ class AutoSwitcher(object):
 					self.current_profile = profile
 				elif line.startswith("Reconfigured."):
 					log.debug("Reloading config...")
-					self.config = Config()
+					self.config = Config.get_shared()
 					self.conds = AutoSwitcher.parse_conditions(self.config)
 				elif line.startswith("Controller Count:"):
 					self.enabled = int(line.split(":")[-1]) > 0
@@ -348,7 +348,7 @@ class AutoswitchOptsMenuGenerator(MenuGenerator):
 		self.title = X.get_window_title(menuhandler.xdisplay, win)
 		self.wm_class = X.get_window_class(menuhandler.xdisplay, win)
 		self.assigned_prof = None
-		self.conds = AutoSwitcher.parse_conditions(Config())
+		self.conds = AutoSwitcher.parse_conditions(Config.get_shared())
 		if self.title and "-" in self.title:
 			self.title = self.title.split("-")[-1]
 		for c in self.conds:
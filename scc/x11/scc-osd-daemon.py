@@ -16,10 +16,12 @@ gi.require_version('GdkX11', '3.0')
 from gi.repository import Gtk, Gdk, GdkX11, GLib
 from scc.gui.daemon_manager import DaemonManager
 from scc.osd.gesture_display import GestureDisplay
+from scc.osd.binding_display import BindingCache
 from scc.osd.radial_menu import RadialMenu
 from scc.osd.hmenu import HorizontalMenu
 from scc.osd.quick_menu import QuickMenu
 from scc.osd.grid_menu import GridMenu
+from scc.osd.menu_pool import MenuPool
 from scc.osd.keyboard import Keyboard
 from scc.osd.message import Message
 from scc.osd.dialog import Dialog
@@ -43,6 +45,8 @@ class OSDDaemon(object):
 		self._hash_of_colors = -1
 		self._visible_messages = {}
 		self._window = None
+		self._pool = None
+		self._bindings = None
 		self._registered = False
 		self._last_profile_change = 0
 		self._recent_profiles_undo = None
@@ -64,6 +68,9 @@ class OSDDaemon(object):
 	
 	
 	def on_profile_changed(self, daemon, profile):
+		self._pool.set_profile(profile)
+		self._bindings.generate_in_background(profile,
+			BindingCache.get_controller_type(daemon))
 		name = os.path.split(profile)[-1]
 		if name.endswith(".sccprofile") and not name.startswith("."):
 			# Ignore .mod and hidden files
@@ -206,6 +213,12 @@ class OSDDaemon(object):
 			if self._window:
 				log.warning("Another OSD is already visible - refusing to show menu")
 			else:
+				self._window = self._pool.get(args)
+				if self._window:
+					# Pre-built window is available, just display it
+					self._window.show()
+					self._window.use_daemon(self.daemon)
+					return
 				if message.startswith("OSD: hmenu"):
 					self._window = HorizontalMenu()
 				elif message.startswith("OSD: radialmenu"):
@@ -281,6 +294,7 @@ class OSDDaemon(object):
 		if self._hash_of_colors != h:
 			self._hash_of_colors = h
 			OSDWindow._apply_css(self.config)
+			self._pool.clear()
 			if self._window and isinstance(self._window, Keyboard):
 				self._window.recolor()
 				self._window.update_labels()
@@ -295,6 +309,8 @@ class OSDDaemon(object):
 			return
 		self.daemon = DaemonManager()
 		self.config = Config()
+		self._pool = MenuPool(self.config, self.on_menu_closed)
+		self._bindings = BindingCache(config=self.config)
 		self._check_colorconfig_change()
 		self.daemon.connect('alive', self.on_daemon_connected)
 		self.daemon.connect('dead', self.on_daemon_died)
@@ -0,0 +1,68 @@
+#!/usr/bin/env python2
+"""
+Measures memory used by actions in default profiles and time taken by
+calling most common action methods.
+
+Not a test, run it as
+`$ PYTHONPATH=. python2 tests/benchmark_actions.py`
+"""
+from scc.constants import STICK_PAD_MAX, TRIGGER_MAX, LEFT, STICK
+from scc.drivers.fake import FakeController
+from scc.parser import ActionParser
+from scc.scheduler import Scheduler
+from scc.profile import Profile
+from scc.mapper import Mapper
+import os, sys, glob, timeit
+
+ROUNDS = 100000
+parser = ActionParser()
+
+CASES = (
+	# action, method, arguments
+	( "button(KEY_A)",						"button_press",		() ),
+	( "axis(ABS_X)",						"axis",				(STICK_PAD_MAX / 2, LEFT) ),
+	( "mouse()",							"whole",			(100, 100, STICK) ),
+	( "XY(axis(ABS_X), axis(ABS_Y))",		"whole",			(100, 100, STICK) ),
+	( "sens(2, 2, XY(axis(ABS_X), axis(ABS_Y)))",	"whole",	(100, 100, STICK) ),
+	( "deadzone(100, XY(axis(ABS_X), axis(ABS_Y)))", "whole",	(100, 100, STICK) ),
+	( "trigger(50, button(KEY_A))",			"trigger",			(TRIGGER_MAX, 0) ),
+	( "mode(A, button(KEY_A), button(KEY_B))",	"button_press",	() ),
+)
+
+
+def get_size(action):
+	rv = sys.getsizeof(action)
+	if hasattr(action, "__dict__"):
+		rv += sys.getsizeof(action.__dict__)
+	return rv
+
+
+def measure_memory():
+	path = os.path.join(os.path.dirname(__file__), "..", "default_profiles")
+	count, size = 0, 0
+	for filename in glob.glob(os.path.join(path, "*.sccprofile")):
+		profile = Profile(parser).load(filename)
+		profile.compress()
+		for action in profile.get_all_actions():
+			count += 1
+			size += get_size(action)
+	print "%s actions in default profiles, %s bytes, %.1f bytes per action" % (
+		count, size, float(size) / max(1, count))
+
+
+def measure_calls():
+	mapper = Mapper(Profile(parser), Scheduler(), keyboard=False, mouse=False,
+		gamepad=False, poller=None)
+	mapper.set_controller(FakeController(0))
+	for string, method, args in CASES:
+		action = parser.restart(string).parse().compress()
+		fn = getattr(action, method)
+		t = timeit.timeit(lambda: fn(mapper, *args), number=ROUNDS)
+		if method == "button_press":
+			action.button_release(mapper)
+		print "%-50s %-14s %.3fus" % (string, method, t * 1000000.0 / ROUNDS)
+
+
+if __name__ == "__main__":
+	measure_memory()
+	measure_calls()
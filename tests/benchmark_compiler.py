@@ -0,0 +1,66 @@
+#!/usr/bin/env python2
+"""
+Measures time taken by processing controller input with every default
+and example profile, with and without functions generated by scc.compiler.
+
+Not a test, run it as
+`$ PYTHONPATH=. python2 tests/benchmark_compiler.py`
+"""
+from scc.drivers.fake import FakeController
+from scc.constants import SCButtons
+from scc.compiler import Dispatcher
+from scc.parser import ActionParser
+from scc.scheduler import Scheduler
+from scc.profile import Profile
+from scc.mapper import Mapper
+from test_inputs import ZERO_STATE
+import os, glob, time
+
+TICKS = 20000
+REPEAT = 5
+parser = ActionParser()
+
+
+def make_states():
+	""" Moves stick, right pad and triggers, but presses nothing """
+	rv, old = [], ZERO_STATE
+	for i in xrange(200):
+		x = (i * 997) % 60000 - 30000
+		state = ZERO_STATE._replace(
+			buttons = SCButtons.RPADTOUCH,
+			ltrig = (i * 17) % 256, rtrig = (i * 31) % 256,
+			lpad_x = x, lpad_y = -x / 3,
+			rpad_x = -x, rpad_y = x / 2,
+		)
+		rv.append((old, state))
+		old = state
+	return rv
+
+
+def measure(filename, interpret, states):
+	profile = Profile(parser).load(filename)
+	profile.compress()
+	mapper = Mapper(profile, Scheduler(), keyboard=False, mouse=False,
+		gamepad=False, poller=None)
+	mapper.set_controller(FakeController(0))
+	mapper.compiled = Dispatcher(interpret)
+	t = time.time()
+	for i in xrange(TICKS / len(states)):
+		for old_state, state in states:
+			mapper.input(mapper.controller, old_state, state)
+	return (time.time() - t) * 1000000.0 / TICKS
+
+
+if __name__ == "__main__":
+	states = make_states()
+	path = os.path.join(os.path.dirname(__file__), "..")
+	for filename in sorted(glob.glob(os.path.join(path, "default_profiles", "*.sccprofile"))
+				+ glob.glob(os.path.join(path, "profile_examples", "*.sccprofile"))):
+		interpreted, compiled = [], []
+		for x in xrange(REPEAT):
+			interpreted.append(measure(filename, True, states))
+			compiled.append(measure(filename, False, states))
+		interpreted, compiled = min(interpreted), min(compiled)
+		print "%-50s interpreted %6.2fus compiled %6.2fus (%+.0f%%)" % (
+			os.path.basename(filename), interpreted, compiled,
+			(interpreted / compiled - 1.0) * 100)
@@ -0,0 +1,61 @@
+#!/usr/bin/env python2
+"""
+Measures how long daemon lock is held while switching profiles, both when
+profile is loaded while lock is held (as daemon used to do) and when only
+already loaded profile is applied under lock.
+
+Not a test, run it as
+`$ PYTHONPATH=. python2 tests/benchmark_profile_switch.py`
+"""
+from scc.drivers.fake import FakeController
+from scc.sccdaemon import SCCDaemon
+from scc.scheduler import Scheduler
+from scc.profile import Profile
+from scc.parser import ActionParser
+from scc.mapper import Mapper
+import os, glob, time, threading, itertools
+
+ROUNDS = 5
+
+
+class BenchmarkDaemon(SCCDaemon):
+	""" Has just enough of SCCDaemon to switch profiles """
+	def __init__(self):
+		self.lock = threading.Lock()
+		self.profile_requests = {}
+		self.profile_serial = itertools.count()
+		self.clients = set()
+		self.default_mapper = None
+
+
+def measure(filenames, load_under_lock):
+	"""
+	Switches between all profiles ROUNDS times.
+	Returns list of lock hold times in milliseconds.
+	"""
+	daemon = BenchmarkDaemon()
+	mapper = Mapper(Profile(ActionParser()), Scheduler(), keyboard=False,
+		mouse=False, gamepad=False, poller=None)
+	mapper.set_controller(FakeController(0))
+	mapper.get_controller().mapper = mapper
+	rv = []
+	for i in xrange(ROUNDS):
+		for filename in filenames:
+			if not load_under_lock:
+				p = daemon._load_profile(filename)
+			with daemon.lock:
+				t = time.time()
+				if load_under_lock:
+					p = daemon._load_profile(filename)
+				daemon._apply_profile(mapper, filename, p)
+				rv.append((time.time() - t) * 1000.0)
+	return rv
+
+
+if __name__ == "__main__":
+	path = os.path.join(os.path.dirname(__file__), "..", "default_profiles")
+	filenames = sorted(glob.glob(os.path.join(path, "*.sccprofile")))
+	for label, load_under_lock in (("loaded under lock", True), ("loaded before lock", False)):
+		times = measure(filenames, load_under_lock)
+		print "%-20s %s switches, max %.2fms, mean %.2fms" % (
+			label, len(times), max(times), sum(times) / len(times))
@@ -0,0 +1,75 @@
+from scc.constants import SCButtons, HapticPos
+from scc.controller import HapticData
+from scc.profile import Profile
+from test_inputs import input_test, parser, ZERO_STATE
+import gc
+
+"""
+Tests that processing input doesn't leave any new objects behind
+"""
+
+TICKS = 200
+
+
+def make_states():
+	""" Returns list of (old_state, state) pairs that cycle through reference profile """
+	rv, old = [], ZERO_STATE
+	for i in xrange(TICKS):
+		x = (i * 997) % 30000 - 15000
+		state = ZERO_STATE._replace(
+			buttons = (SCButtons.A | SCButtons.RPADTOUCH) if i % 4 < 2 else SCButtons.LPADTOUCH,
+			ltrig = (i * 10) % 255,
+			stick_x = x, stick_y = -x,
+			lpad_x = -x, lpad_y = x,
+			rpad_x = x, rpad_y = x / 2,
+		)
+		rv.append((old, state))
+		old = state
+	return rv
+
+
+class TestAllocations(object):
+	
+	@input_test
+	def test_tick_allocations(self, mapper):
+		"""
+		Tests that mapper tick with reference profile doesn't leave any new
+		object tracked by garbage collector behind and that output buffers
+		are reused.
+		"""
+		mapper.profile.buttons[SCButtons.A] = parser.restart("button(KEY_A)").parse()
+		mapper.profile.stick = parser.restart("XY(axis(ABS_X), axis(ABS_Y))").parse()
+		mapper.profile.triggers[Profile.LEFT] = parser.restart("trigger(50, button(KEY_B))").parse()
+		mapper.profile.pads[Profile.LEFT] = parser.restart("dpad(button(KEY_UP), button(KEY_DOWN), button(KEY_LEFT), button(KEY_RIGHT))").parse()
+		mapper.profile.pads[Profile.RIGHT] = parser.restart("feedback(BOTH, mouse())").parse().compress()
+		states = make_states()
+		buffers = [ id(x) for x in (mapper.keypress_list, mapper.keyrelease_list,
+			mapper.mouse_movements, mapper.syn_list, mapper.feedbacks) ]
+		
+		# Warm-up, fills all caches
+		for old_state, state in states:
+			mapper.input(mapper.controller, old_state, state)
+		
+		gc.collect()
+		gc.disable()
+		try:
+			before = len(gc.get_objects())
+			for old_state, state in states:
+				mapper.input(mapper.controller, old_state, state)
+			after = len(gc.get_objects())
+		finally:
+			gc.enable()
+		assert after == before, "%s objects left behind" % (after - before,)
+		assert buffers == [ id(x) for x in (mapper.keypress_list, mapper.keyrelease_list,
+			mapper.mouse_movements, mapper.syn_list, mapper.feedbacks) ]
+	
+	
+	def test_haptic_copies(self):
+		"""
+		Tests that splitting feedback to both sides doesn't create new
+		HapticData every time.
+		"""
+		hd = HapticData(HapticPos.BOTH, 1024)
+		assert hd.with_position(HapticPos.LEFT) is hd.with_position(HapticPos.LEFT)
+		assert hd.with_position(HapticPos.LEFT).get_position() == HapticPos.LEFT
+		assert hd.with_position(HapticPos.RIGHT).get_amplitude() == 1024
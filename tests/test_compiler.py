@@ -0,0 +1,119 @@
+from scc.drivers.fake import FakeController
+from scc.constants import SCButtons
+from scc.uinput import Axes
+from scc.compiler import Dispatcher
+from scc.scheduler import Scheduler
+from scc.profile import Profile
+from scc.mapper import Mapper
+from test_inputs import RememberingDummy, parser, ZERO_STATE
+
+"""
+Tests that functions generated from profile do exactly
+same thing as action tree they were generated from.
+"""
+
+BINDINGS = (
+	# stick, lpad, rpad, ltrig, rtrig
+	( "XY(axis(ABS_X), raxis(ABS_Y))", "XY(axis(ABS_HAT0X), axis(ABS_HAT0Y))",
+		"XY(axis(ABS_RX), axis(ABS_RY))", "axis(ABS_Z)", "raxis(ABS_RZ)" ),
+	( "deadzone(2000, XY(axis(ABS_X), axis(ABS_Y)))", "XY(hatleft(ABS_HAT0X), None)",
+		"mouse()", "axis(ABS_Z, 0, 100)", "trigger(50, button(KEY_A))" ),
+	( "sens(2, 0.5, XY(axis(ABS_X), axis(ABS_Y)))", "dpad(button(KEY_UP), button(KEY_DOWN))",
+		"deadzone(ROUND, 1000, 20000, XY(axis(ABS_RX), None))", "None",
+		"axis(ABS_RZ) and trigger(200, button(KEY_B))" ),
+	( "None", "XY(button(KEY_X), axis(ABS_Y))", "rotate(20, XY(axis(ABS_RX), axis(ABS_RY)))",
+		"axis(ABS_Z, 50, 200)", "sens(0.5, axis(ABS_RZ))" ),
+)
+
+
+def make_mapper(interpret):
+	mapper = Mapper(Profile(parser), Scheduler(), keyboard=False, mouse=False,
+		gamepad=False, poller=None)
+	mapper.keyboard = RememberingDummy()
+	mapper.gamepad = RememberingDummy()
+	mapper.mouse = RememberingDummy()
+	mapper.set_controller(FakeController(0))
+	mapper.compiled = Dispatcher(interpret)
+	mapper._testing = True
+	return mapper
+
+
+def set_bindings(mapper, bindings):
+	p = mapper.profile
+	p.stick, p.pads[Profile.LEFT], p.pads[Profile.RIGHT], \
+		p.triggers[Profile.LEFT], p.triggers[Profile.RIGHT] = [
+			parser.restart(x).parse().compress() for x in bindings ]
+
+
+def make_states():
+	rv, old = [], ZERO_STATE
+	for i in xrange(100):
+		x = (i * 997) % 60000 - 30000
+		state = ZERO_STATE._replace(
+			buttons = SCButtons.RPADTOUCH | (SCButtons.LPADTOUCH if i % 6 < 3 else 0),
+			ltrig = (i * 17) % 256, rtrig = (i * 31) % 256,
+			lpad_x = x, lpad_y = -x / 3,
+			rpad_x = -x, rpad_y = x / 2,
+		)
+		rv.append((old, state))
+		old = state
+	return rv
+
+
+def get_output(mapper):
+	return (dict(mapper.gamepad.axes), set(mapper.keyboard.pressed),
+		mapper.mouse.mouse_x, mapper.mouse.mouse_y)
+
+
+class TestCompiler(object):
+	
+	def test_same_output(self):
+		"""
+		Tests that compiled functions generate same output as
+		interpreted actions.
+		"""
+		for bindings in BINDINGS:
+			compiled, interpreted = make_mapper(False), make_mapper(True)
+			set_bindings(compiled, bindings)
+			set_bindings(interpreted, bindings)
+			for old_state, state in make_states():
+				compiled.input(compiled.controller, old_state, state)
+				interpreted.input(interpreted.controller, old_state, state)
+				assert get_output(compiled) == get_output(interpreted), bindings
+	
+	
+	def test_inlined(self):
+		"""
+		Tests that simple actions are inlined and stateful ones are called.
+		"""
+		mapper = make_mapper(False)
+		set_bindings(mapper, BINDINGS[1])
+		code = lambda name: mapper.compiled.compile(mapper, name).code
+		assert "axisEvent" in code("stick")
+		assert "axisEvent" in code("ltrig")
+		assert "axisEvent" not in code("rpad")
+		assert "axisEvent" not in code("rtrig")
+	
+	
+	def test_recompile(self):
+		"""
+		Tests that function is generated again when action assigned
+		to input is replaced.
+		"""
+		mapper = make_mapper(False)
+		set_bindings(mapper, BINDINGS[0])
+		state = ZERO_STATE._replace(lpad_x=1000, ltrig=255)
+		mapper.input(mapper.controller, ZERO_STATE, state)
+		assert set(mapper.gamepad.axes) == { Axes.ABS_X, Axes.ABS_Y, Axes.ABS_Z }
+		
+		mapper.profile.stick = parser.restart("XY(axis(ABS_RX), axis(ABS_RY))").parse()
+		mapper.profile.triggers[Profile.LEFT] = parser.restart("axis(ABS_RZ)").parse()
+		mapper.gamepad.axes = {}
+		mapper.input(mapper.controller, state, state._replace(lpad_x=2000, ltrig=128))
+		assert set(mapper.gamepad.axes) == { Axes.ABS_RX, Axes.ABS_RY, Axes.ABS_RZ }
+		
+		mapper.set_controller(mapper.controller)
+		mapper.profile.stick = parser.restart("None").parse()
+		mapper.gamepad.axes = {}
+		mapper.input(mapper.controller, state, state._replace(lpad_x=3000))
+		assert mapper.gamepad.axes == { }
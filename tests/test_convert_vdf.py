@@ -0,0 +1,33 @@
+from scc.scripts import cmd_convert_vdf
+from scc.parser import ActionParser
+from scc.profile import Profile
+import os, glob, shutil, tempfile
+
+"""
+Tests 'scc convert-vdf' command
+"""
+
+VDFS = os.path.join(os.path.dirname(__file__), "vdfs")
+
+
+class TestConvertVDF(object):
+	
+	def test_convert(self):
+		"""
+		Tests that every fixture is converted to profile that can be loaded
+		and that converted files are skipped on next run
+		"""
+		target = tempfile.mkdtemp()
+		try:
+			assert cmd_convert_vdf("scc", [ "-j", "2", VDFS, target ]) == 0
+			for f in glob.glob(os.path.join(VDFS, "*.vdf")):
+				name = os.path.splitext(os.path.basename(f))[0]
+				output = os.path.join(target, name + ".sccprofile")
+				assert os.path.exists(output), output
+				Profile(ActionParser()).load(output)
+			assert not glob.glob(os.path.join(target, "*.tmp"))
+			mtimes = { f : os.stat(f).st_mtime for f in glob.glob(os.path.join(target, "*")) }
+			assert cmd_convert_vdf("scc", [ VDFS, target ]) == 0
+			assert mtimes == { f : os.stat(f).st_mtime for f in glob.glob(os.path.join(target, "*")) }
+		finally:
+			shutil.rmtree(target)
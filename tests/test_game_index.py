@@ -0,0 +1,92 @@
+from scc.game_index import GameIndex
+import os, shutil, tempfile, time
+
+"""
+Tests list of games maintained by daemon
+"""
+
+DESKTOP_FILE = """[Desktop Entry]
+Type=Application
+Name=%s
+Categories=Game;
+"""
+
+
+class FakeScheduler(object):
+	def schedule(self, delay, callback):
+		return True
+
+
+class FakeDaemon(object):
+	def get_poller(self):
+		return self
+	
+	def get_scheduler(self):
+		return FakeScheduler()
+	
+	POLLIN = 1
+	def register(self, fd, events, callback):
+		pass
+
+
+class TestGameIndex(object):
+	
+	@staticmethod
+	def _add(directory, name):
+		if not os.path.exists(directory):
+			os.makedirs(directory)
+		with open(os.path.join(directory, name + ".desktop"), "w") as f:
+			f.write(DESKTOP_FILE % (name,))
+	
+	
+	@staticmethod
+	def _process(index):
+		""" Processes inotify events and runs scan, as daemon would """
+		time.sleep(0.1)
+		index.on_data_ready()
+		index._task = None
+		index.rescan()
+		return [ x["name"] for x in index.get_games() ]
+	
+	
+	def test_recreated(self):
+		"""
+		Tests if games are found in directory that was removed and
+		created again.
+		"""
+		tmp, cache = tempfile.mkdtemp(), tempfile.mkdtemp()
+		old_env = os.environ.get("XDG_DATA_HOME"), os.environ.get("XDG_DATA_DIRS")
+		os.environ["XDG_DATA_HOME"] = os.path.join(tmp, "home")
+		os.environ["XDG_DATA_DIRS"] = os.path.join(tmp, "usr")
+		os.makedirs(os.path.join(tmp, "usr", "applications"))
+		try:
+			subdir = os.path.join(tmp, "home", "applications", "sub")
+			self._add(subdir, "A")
+			index = GameIndex(os.path.join(cache, "games.json"))
+			index.start(FakeDaemon())
+			index._thread.join()
+			assert [ x["name"] for x in index.get_games() ] == [ "A" ]
+			assert GameIndex.read_games(index.filename)[0]["name"] == "A"
+			
+			shutil.rmtree(subdir)
+			assert self._process(index) == [ ]
+			self._add(subdir, "B")
+			assert self._process(index) == [ "B" ]
+			self._add(subdir, "C")
+			assert self._process(index) == [ "B", "C" ]
+			
+			# Same for applications directory itself
+			shutil.rmtree(os.path.join(tmp, "home", "applications"))
+			assert self._process(index) == [ ]
+			self._add(os.path.join(tmp, "home", "applications"), "D")
+			assert self._process(index) == [ "D" ]
+			self._add(os.path.join(tmp, "home", "applications"), "E")
+			assert self._process(index) == [ "D", "E" ]
+		finally:
+			for key, value in zip(("XDG_DATA_HOME", "XDG_DATA_DIRS"), old_env):
+				if value is None:
+					os.environ.pop(key, None)
+				else:
+					os.environ[key] = value
+			shutil.rmtree(tmp)
+			shutil.rmtree(cache)
@@ -0,0 +1,75 @@
+from scc.gesture_index import GestureIndex, gesture_distance
+from scc.gestures import GestureDetector
+from scc.parser import ActionParser
+from scc.constants import LEFT, STICK_PAD_MIN, STICK_PAD_MAX
+import random
+
+"""
+Tests finding actions assigned to gestures
+"""
+
+parser = ActionParser()
+
+
+class TestGestures(object):
+	
+	def test_distance(self):
+		""" Tests that distance is number of removed and inserted characters """
+		assert gesture_distance("UDLR", "UDLR") == 0
+		assert gesture_distance("UDLR", "UDR") == 1
+		assert gesture_distance("UDLR", "RLDU") == 6
+		assert gesture_distance("", "UD") == 2
+	
+	
+	def test_exact(self):
+		""" Tests exact and stroke-length ignoring lookups """
+		index = GestureIndex({ "UD" : 1, "iLR" : 2 }, 1.0)
+		assert index.find("UD") == 1
+		assert index.find("LLLRR") == 2
+		assert index.find("LRL") is None
+		assert index.find("UDD") is None
+	
+	
+	def test_similar(self):
+		"""
+		Tests that index finds most similar gesture, same as comparing
+		with every gesture would
+		"""
+		r = random.Random(0)
+		string = lambda : "".join([ r.choice("UDLR") for x in xrange(r.randint(1, 8)) ])
+		for precision in (0.0, 0.5, 0.75, 0.9):
+			gestures = { string() : x for x in xrange(40) }
+			index = GestureIndex(gestures, precision)
+			for x in xrange(100):
+				s = string()
+				ratio, best = max([
+					(1.0 - float(gesture_distance(s, g)) / (len(s) + len(g)), g)
+					for g in gestures ])
+				expected = gestures[best] if ratio >= precision else None
+				assert index.find(s) in (gestures.get(s), expected)
+	
+	
+	def test_matcher(self):
+		"""
+		Tests that gesture is recognized while it's drawn by GestureDetector
+		"""
+		a = parser.restart("gestures('DDRR', button(KEY_A), 'iUL', button(KEY_B))").parse()
+		matcher = a.get_matcher()
+		detected = []
+		gd = GestureDetector(0, lambda gd, gstr : detected.append(gstr), matcher)
+		gd.enable()
+		assert matcher.get_action() is None
+		# Top left corner, down, then right
+		for x, y in ((STICK_PAD_MIN, STICK_PAD_MAX), (STICK_PAD_MIN, STICK_PAD_MIN),
+					(STICK_PAD_MAX, STICK_PAD_MIN)):
+			gd.whole(None, x, y, LEFT)
+		assert matcher.get_action() is a.gestures["DDRR"]
+		gd.whole(None, 0, 0, LEFT)
+		assert detected == [ "DDRR" ]
+		assert a.find_gesture_action("DDRR", matcher) is a.gestures["DDRR"]
+		
+		gd.enable()
+		for x, y in ((STICK_PAD_MAX, STICK_PAD_MIN), (STICK_PAD_MAX, STICK_PAD_MAX),
+					(STICK_PAD_MIN, STICK_PAD_MAX)):
+			gd.whole(None, x, y, LEFT)
+		assert a.find_gesture_action(gd.get_string(), matcher) is a.gestures["iUL"]
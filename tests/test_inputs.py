@@ -247,3 +247,26 @@ class TestInputs(object):
 		_state, state = state, state._replace(buttons=SCButtons.A)
 		mapper.input(mapper.controller, _state, state)
 		assert Keys.KEY_Y in mapper.keyboard.pressed
+	
+	
+	@input_test
+	def test_modeshift_order(self, mapper):
+		"""
+		Tests that button and range conditions are tested in order
+		they are defined in
+		"""
+		mapper.profile.buttons[SCButtons.A] = (parser.restart(
+			"mode(B, button(Keys.KEY_V), LT >= 0.5, button(Keys.KEY_X), "
+			"Y, button(Keys.KEY_Z), button(Keys.KEY_Y))"
+		)).parse().compress()
+		for buttons, ltrig, key in (
+					(SCButtons.A, 0, Keys.KEY_Y),
+					(SCButtons.A | SCButtons.Y, 0, Keys.KEY_Z),
+					(SCButtons.A | SCButtons.Y, 255, Keys.KEY_X),
+					(SCButtons.A | SCButtons.B | SCButtons.Y, 255, Keys.KEY_V),
+				):
+			state = ZERO_STATE._replace(buttons=buttons, ltrig=ltrig)
+			mapper.input(mapper.controller, ZERO_STATE, state)
+			assert mapper.keyboard.pressed == { key }
+			mapper.input(mapper.controller, state, ZERO_STATE)
+			assert not mapper.keyboard.pressed
@@ -0,0 +1,123 @@
+from scc.uinput import Keys, Scans, MacroPlayer
+from scc.parser import ActionParser
+
+"""
+Tests compiling macros to scripts played by MacroPlayer
+"""
+
+parser = ActionParser()
+KEYBOARD, MOUSE, GAMEPAD = MacroPlayer.KEYBOARD, MacroPlayer.MOUSE, MacroPlayer.GAMEPAD
+
+
+def key_events(macro):
+	""" Returns compiled script of macro without scan events """
+	events, length = macro._script
+	return [ (e.time, e.device, e.code, e.value) for e in events if e.type == 1 ], length
+
+
+class TestMacroPlayer(object):
+	
+	def test_timing(self):
+		"""
+		Tests that compiled script has same timing as macro played
+		by scheduler
+		"""
+		a = parser.restart("button(KEY_A); sleep(0.5); press(KEY_B); release(KEY_B)").parse()
+		events, length = key_events(a)
+		assert events == [
+			(0,			KEYBOARD, Keys.KEY_A, 1),
+			(10000,		KEYBOARD, Keys.KEY_A, 0),
+			(520000,	KEYBOARD, Keys.KEY_B, 1),
+			(540000,	KEYBOARD, Keys.KEY_B, 0),
+		]
+		assert length == 560000
+	
+	
+	def test_devices(self):
+		""" Tests that mouse and gamepad buttons are sent to correct devices """
+		a = parser.restart("button(BTN_LEFT); button(BTN_A); button(KEY_ENTER)").parse()
+		events, length = key_events(a)
+		assert [ d for t, d, k, v in events ] == [ MOUSE, MOUSE, GAMEPAD, GAMEPAD, KEYBOARD, KEYBOARD ]
+	
+	
+	def test_scan_codes(self):
+		""" Tests that keyboard keys are preceded by scan events """
+		a = parser.restart("button(KEY_A); button(KEY_B)").parse()
+		events, length = a._script
+		assert events[0].type == 4 and events[0].value == Scans[Keys.KEY_A]
+		assert events[1].type == 1 and events[1].code == Keys.KEY_A
+	
+	
+	def test_repeat(self):
+		""" Tests that repeat() is compiled as well """
+		a = parser.restart("repeat(button(BTN_X))").parse()
+		events, length = key_events(a)
+		assert a.repeat
+		assert events == [ (0, GAMEPAD, Keys.BTN_X, 1), (10000, GAMEPAD, Keys.BTN_X, 0) ]
+		assert length == 20000
+	
+	
+	def test_not_compiled(self):
+		"""
+		Tests that macros with anything else than buttons and sleeps
+		are left for scheduler
+		"""
+		for a in ("button(KEY_A); mouse()", "button(KEY_A); type('a')",
+					"button(KEY_A); tap(KEY_B)", "button(Rels.REL_WHEEL); button(KEY_A)"):
+			assert parser.restart(a).parse()._script is None, a
+	
+	
+	def test_late_notifications(self):
+		"""
+		Tests that notification about finished or canceled playback
+		doesn't affect playback of same macro started after it
+		"""
+		class FakePlayer(object):
+			def __init__(self):
+				self.playing = {}
+				self.last_id = 0
+			
+			def play(self, events, length, repeat, callback):
+				self.last_id += 1
+				self.playing[self.last_id] = [ repeat, callback ]
+				return self.last_id
+			
+			def cancel(self, id):
+				pass
+			
+			def set_repeat(self, id, repeat):
+				if id not in self.playing:
+					return False
+				self.playing[id][0] = repeat
+				return True
+			
+			def finish(self, id, what=MacroPlayer.FINISHED):
+				self.playing.pop(id)[1](id, what)
+		
+		class FakeMapper(object):
+			player = FakePlayer()
+			def get_macro_player(self):
+				return self.player
+		
+		mapper = FakeMapper()
+		player = mapper.player
+		a = parser.restart("repeat(button(KEY_A); button(KEY_B))").parse()
+		a.button_press(mapper)
+		assert a._playing == (player, 1)
+		# Canceled and pressed again before notification arrives
+		a.cancel(mapper)
+		callback = player.playing.pop(1)[1]
+		a.button_press(mapper)
+		assert a._playing == (player, 2)
+		callback(1, MacroPlayer.CANCELED)
+		assert a._playing == (player, 2)
+		a.button_release(mapper)
+		assert player.playing[2][0] is False
+		# Finished, but pressed again before notification arrives
+		callback = player.playing.pop(2)[1]
+		a.button_press(mapper)
+		assert a._playing == (player, 3)
+		callback(2, MacroPlayer.FINISHED)
+		assert a._playing == (player, 3)
+		player.finish(3)
+		assert a._playing is None
@@ -0,0 +1,113 @@
+from scc.constants import SCButtons
+from scc.uinput import Keys
+from scc.profile import Profile, LazyAction, LazyMenu
+from scc.actions import ButtonAction
+from . import parser
+from io import StringIO
+import json, threading
+
+DATA = json.dumps({
+	"buttons" : {
+		"A" : { "action" : "button(KEY_A)" },
+		"B" : { "action" : "sens(2.0, mouse())" },
+	},
+	"stick" : { "action" : "dpad(button(KEY_UP), button(KEY_DOWN))" },
+	"menus" : {
+		"menu1" : [ { "id" : "item1", "action" : "button(KEY_X)", "name" : "X" } ],
+	},
+	"version" : Profile.VERSION,
+}).decode("utf-8")
+
+class TestLazy(object):
+	"""
+	Tests loading profile with actions parsed only when needed.
+	"""
+	
+	def test_lazy(self):
+		"""
+		Tests if actions are parsed on first use and then replace
+		LazyAction in profile.
+		"""
+		p = Profile(parser).load_fileobj(StringIO(DATA), lazy=True)
+		p.compress()
+		assert isinstance(p.buttons[SCButtons.A], LazyAction)
+		assert isinstance(p.menus["menu1"], LazyMenu)
+		lazy = p.buttons[SCButtons.A]
+		assert lazy.button == Keys.KEY_A
+		assert isinstance(p.buttons[SCButtons.A], ButtonAction)
+		assert len(p.menus["menu1"]) == 1
+		assert not isinstance(p.menus["menu1"], LazyMenu)
+	
+	
+	def test_same_as_eager(self):
+		"""
+		Tests if lazily loaded profile ends same as normally loaded one.
+		"""
+		lazy = Profile(parser).load_fileobj(StringIO(DATA), lazy=True)
+		eager = Profile(parser).load_fileobj(StringIO(DATA))
+		lazy.compress()
+		eager.compress()
+		lazy.prewarm()
+		for x in SCButtons:
+			assert lazy.buttons[x].to_string() == eager.buttons[x].to_string()
+		assert lazy.stick.to_string() == eager.stick.to_string()
+		assert lazy.signatures == eager.signatures
+	
+	
+	def test_reused(self):
+		"""
+		Tests if action that was not parsed yet replaces itself in new
+		profile after it was reused when switching profiles.
+		"""
+		old = Profile(parser).load_fileobj(StringIO(DATA), lazy=True)
+		new = Profile(parser).load_fileobj(StringIO(DATA), lazy=True)
+		old.compress()
+		new.compress()
+		lazy = old.buttons[SCButtons.A]
+		new.reuse_actions(old)
+		assert new.buttons[SCButtons.A] is lazy
+		assert lazy.button == Keys.KEY_A
+		assert isinstance(new.buttons[SCButtons.A], ButtonAction)
+		assert new.buttons[SCButtons.A] is lazy.materialize()
+		# Already parsed action is reused directly
+		new.prewarm()
+		newer = Profile(parser).load_fileobj(StringIO(DATA), lazy=True)
+		newer.compress()
+		newer.reuse_actions(new)
+		assert newer.stick is new.stick
+		assert not isinstance(newer.stick, LazyAction)
+	
+	
+	def test_threads(self):
+		"""
+		Tests if actions sharing one parser can be parsed from two threads
+		at once, as when profile is prewarmed while input is processed.
+		"""
+		data = json.loads(DATA)
+		for i in xrange(500):
+			data["menus"]["menu%s" % (i,)] = [
+				{ "id" : "item%s" % (j,), "name" : "X",
+				"action" : "mode(A, sens(%s, mouse()), B, dpad(button(KEY_%s), button(KEY_B)))" % (j + 1, "XYZ"[j]) }
+				for j in xrange(3)
+			]
+		data = json.dumps(data).decode("utf-8")
+		lazy = Profile(parser).load_fileobj(StringIO(data), lazy=True)
+		eager = Profile(parser).load_fileobj(StringIO(data))
+		names = sorted(lazy.menus.keys())
+		errors = []
+		menus = [ lazy.menus[name] for name in reversed(names) ]
+		def materialize():
+			try:
+				for m in menus:
+					m.materialize()
+			except Exception, e:
+				errors.append(e)
+		t = threading.Thread(target=lazy.prewarm)
+		t.start()
+		materialize()
+		t.join()
+		assert errors == []
+		for name in names:
+			assert not isinstance(lazy.menus[name], LazyMenu)
+			assert ([ x.action.to_string() for x in lazy.menus[name] ]
+					== [ x.action.to_string() for x in eager.menus[name] ])
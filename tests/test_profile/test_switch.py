@@ -0,0 +1,84 @@
+from scc.constants import SCButtons
+from scc.profile import Profile
+from scc.mapper import Mapper
+from scc.scheduler import Scheduler
+from scc.sccdaemon import SCCDaemon, Client, LockedAction, ObservingAction, ReportingAction
+from . import parser
+from io import StringIO
+import json
+
+class TestSwitch(object):
+	"""
+	Tests comparing profiles when switching between them.
+	"""
+	
+	@staticmethod
+	def _load(buttons, stick="mouse()"):
+		data = {
+			"buttons" : { k : { "action" : v } for (k, v) in buttons.items() },
+			"stick" : { "action" : stick },
+			"version" : Profile.VERSION,
+		}
+		p = Profile(parser)
+		p.load_fileobj(StringIO(json.dumps(data).decode("utf-8")))
+		p.compress()
+		return p
+	
+	
+	def test_same(self):
+		"""
+		Tests if all actions are reused when switching to identical profile.
+		"""
+		old = self._load({ "A" : "button(KEY_A)", "B" : "sens(2.0, button(KEY_B))" })
+		new = self._load({ "A" : "button(KEY_A)", "B" : "sens(2.0, button(KEY_B))" })
+		kept, dropped = new.reuse_actions(old)
+		assert len(dropped) == 0
+		assert new.buttons[SCButtons.A] is old.buttons[SCButtons.A]
+		assert new.buttons[SCButtons.B] is old.buttons[SCButtons.B]
+		assert new.stick is old.stick
+	
+	
+	def test_changed(self):
+		"""
+		Tests if only changed actions are dropped, including changes hidden
+		by compressing, like sensitivity.
+		"""
+		old = self._load({ "A" : "button(KEY_A)", "B" : "sens(2.0, mouse())" })
+		new = self._load({ "A" : "button(KEY_A)", "B" : "sens(3.0, mouse())" }, stick="None")
+		kept, dropped = new.reuse_actions(old)
+		assert new.buttons[SCButtons.A] is old.buttons[SCButtons.A]
+		assert new.buttons[SCButtons.B] is not old.buttons[SCButtons.B]
+		assert new.stick is not old.stick
+		assert old.buttons[SCButtons.B] in dropped
+		assert old.stick in dropped
+		assert old.buttons[SCButtons.A] in kept
+	
+	
+	def test_locked(self):
+		"""
+		Tests that switching profile while input is locked and observed by
+		client keeps original action, not lock, and that lock is removed
+		completly once client unlocks it.
+		"""
+		class FakeDaemon(object):
+			_apply = SCCDaemon.__dict__["_apply"]
+		
+		daemon = FakeDaemon()
+		old = self._load({ "A" : "button(KEY_A)" })
+		original = old.buttons[SCButtons.A]
+		mapper = Mapper(old, Scheduler(), keyboard=False, mouse=False, gamepad=False)
+		client = Client(None, mapper, None, None)
+		client.observe_action(daemon, SCButtons.A)
+		client.lock_action(daemon, SCButtons.A)
+		
+		new = self._load({ "A" : "button(KEY_A)" })
+		mapper.switch_profile(new, ReportingAction.unwrap)
+		assert new.buttons[SCButtons.A] is original
+		client.reaply_locks(daemon, mapper)
+		a = new.buttons[SCButtons.A]
+		assert isinstance(a, ObservingAction)
+		assert isinstance(a.original_action, LockedAction)
+		assert a.original_action.original_action is original
+		
+		client.unlock_actions(daemon)
+		assert new.buttons[SCButtons.A] is original
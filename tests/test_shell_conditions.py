@@ -0,0 +1,115 @@
+from scc.shell_conditions import ShellConditions
+from scc.profile import Profile, LazyAction
+from scc.constants import SCButtons
+from scc.parser import ActionParser
+from scc.sccdaemon import SCCDaemon
+from scc.mapper import Mapper
+from scc.scheduler import Scheduler
+from scc.spawner import Spawner
+from scc.poller import Poller
+from io import StringIO
+import json, time
+
+"""
+Tests background evaluation of 'shell' modeshift conditions
+"""
+
+
+def make_shell_conditions():
+	poller = Poller()
+	spawner = Spawner(poller)
+	spawner.start()
+	return ShellConditions(spawner, Scheduler())
+
+
+def wait_for(sc, command):
+	""" Runs mainloop until command finishes """
+	deadline = time.time() + 5
+	while command in sc._running and time.time() < deadline:
+		sc.spawner.poller.poll(0.01)
+		sc.scheduler.run()
+
+
+class TestShellConditions(object):
+	
+	def test_cached(self):
+		"""
+		Tests that result is returned without waiting and cached
+		for 'ttl' seconds
+		"""
+		sc = make_shell_conditions()
+		sc.ttl = 60
+		assert sc.get("true") is False		# not known yet
+		assert "true" in sc._running
+		wait_for(sc, "true")
+		assert sc.get("true") is True
+		assert "true" not in sc._running	# still fresh
+		
+		assert sc.get("false") is False
+		wait_for(sc, "false")
+		assert sc.get("false") is False
+	
+	
+	def test_expired(self):
+		"""
+		Tests that old result is returned and command executed again
+		once 'ttl' expires
+		"""
+		sc = make_shell_conditions()
+		sc.ttl = 60
+		sc.get("true")
+		wait_for(sc, "true")
+		sc._results["true"] = 0, True
+		assert sc.get("true") is True
+		assert "true" in sc._running
+		wait_for(sc, "true")
+		assert sc._results["true"][0] > 0
+	
+	
+	def test_spawn_failed(self):
+		"""
+		Tests that command that couldn't be started is not considered
+		running, so it's executed again on next request
+		"""
+		sc = make_shell_conditions()
+		sc.ttl = 60
+		spawn = sc.spawner.spawn
+		sc.spawner.spawn = lambda command, callback: None
+		assert sc.get("true") is False
+		assert "true" not in sc._running
+		sc.spawner.spawn = spawn
+		assert sc.get("true") is False
+		assert "true" in sc._running
+		wait_for(sc, "true")
+		assert sc.get("true") is True
+	
+	
+	def test_profile(self):
+		"""
+		Tests that conditions used by profile are evaluated when profile
+		is applied, before they are needed for first time
+		"""
+		data = json.dumps({
+			"buttons" : {
+				"A" : { "action" : "mode(shell('true'), button(KEY_A), button(KEY_B))" },
+				"B" : { "action" : "button(KEY_B)" },
+			},
+			"version" : Profile.VERSION,
+		}).decode("utf-8")
+		p = Profile(ActionParser()).load_fileobj(StringIO(data), lazy=True)
+		p.compress()
+		assert p.get_shell_commands() == { "true" }
+		# Action without condition is not parsed only to find that out
+		assert isinstance(p.buttons[SCButtons.B], LazyAction)
+		
+		class FakeDaemon(object):
+			_evaluate_shell_conditions = SCCDaemon.__dict__["_evaluate_shell_conditions"]
+		
+		daemon = FakeDaemon()
+		daemon.shell_conditions = sc = make_shell_conditions()
+		mapper = Mapper(p, sc.scheduler, keyboard=False, mouse=False,
+			gamepad=False, poller=None)
+		daemon._evaluate_shell_conditions(mapper)
+		assert "true" in sc._running
+		wait_for(sc, "true")
+		assert sc.get("true") is True
@@ -0,0 +1,30 @@
+from scc.parser import ActionParser
+import scc.actions, scc.modifiers, scc.macros
+import inspect
+
+parser = ActionParser()
+
+
+class TestSlots(object):
+	
+	def test_slots_defined(self):
+		"""
+		Tests if every action, modifier and macro class defines __slots__.
+		Class without __slots__ gives __dict__ back to all its instances.
+		"""
+		for module in (scc.actions, scc.modifiers, scc.macros):
+			for name, cls in inspect.getmembers(module, inspect.isclass):
+				if cls.__module__ == module.__name__:
+					assert "__slots__" in cls.__dict__, "%s has no __slots__" % (name,)
+	
+	
+	def test_no_dict(self):
+		"""
+		Tests if parsed actions have no __dict__.
+		"""
+		for string in ("button(KEY_A)", "XY(axis(ABS_X), mouse(REL_Y))",
+					"sens(2, 2, ball(mouse()))", "mode(A, dpad(button(KEY_A)), None)",
+					"button(KEY_A); button(KEY_B)", "doubleclick(button(KEY_A), None)"):
+			a = parser.restart(string).parse()
+			for x in a.get_all_actions():
+				assert not hasattr(x, "__dict__"), "%s has __dict__" % (x.__class__.__name__,)
@@ -0,0 +1,51 @@
+from scc.spawner import Spawner
+from scc.poller import Poller
+import os, time, select
+
+"""
+Tests executing commands through helper process
+"""
+
+
+class TestSpawner(object):
+	
+	def test_exit_codes(self):
+		"""
+		Tests that exit codes are reported, including killed commands
+		"""
+		spawner = Spawner(Poller())
+		spawner.start()
+		codes = {}
+		spawner.spawn("true", lambda c: codes.__setitem__("true", c))
+		spawner.spawn("exit 3", lambda c: codes.__setitem__("exit", c))
+		id = spawner.spawn("sleep 10", lambda c: codes.__setitem__("sleep", c))
+		spawner.kill(id)
+		deadline = time.time() + 5
+		while len(codes) < 3 and time.time() < deadline:
+			spawner.poller.poll(0.01)
+		assert codes == { "true" : 0, "exit" : 3, "sleep" : -9 }
+	
+	
+	def test_inherited_fds(self):
+		"""
+		Tests that helper doesn't keep descriptors opened by daemon
+		"""
+		rfd, wfd = os.pipe()
+		spawner = Spawner(Poller())
+		spawner.start()
+		os.close(wfd)
+		r, trash, trash = select.select([ rfd ], [], [], 5)
+		# EOF is reported only if helper doesn't hold write end as well
+		assert r == [ rfd ]
+		assert os.read(rfd, 1) == b""
+		os.close(rfd)
+	
+	
+	def test_failed(self):
+		"""
+		Tests that None is returned if command can't be passed to helper
+		"""
+		spawner = Spawner(Poller())
+		spawner._send = lambda message : False
+		assert spawner.spawn("true", lambda c: None) is None
+		assert spawner._callbacks == {}
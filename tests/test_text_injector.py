@@ -0,0 +1,149 @@
+#!/usr/bin/env python2
+# -*- coding: utf-8 -*-
+from __future__ import unicode_literals
+
+from scc.text_injector import TextInjector, KeyboardLayout, keysym_to_unicode
+from scc.parser import ActionParser
+from scc.scheduler import Scheduler
+from scc.profile import Profile
+from scc.mapper import Mapper
+from scc.uinput import Keys
+import time
+
+"""
+Tests converting text to key events, using default (US) layout
+"""
+
+
+class FakeKeyboard(object):
+	def __init__(self):
+		self.writes = []
+	
+	def keyEvents(self, events):
+		self.writes.append(list(events))
+
+
+class FakeMapper(object):
+	def __init__(self):
+		self.keyboard = FakeKeyboard()
+		self.scheduler = Scheduler()
+		self.text_injector = TextInjector(self)
+	
+	def get_xdisplay(self):
+		return None
+	
+	def schedule(self, delay, cb):
+		return self.scheduler.schedule(delay, cb, self)
+	
+	def run(self):
+		""" Runs scheduler until everything is typed """
+		deadline = time.time() + 5
+		while self.text_injector._running and time.time() < deadline:
+			self.scheduler.run()
+	
+	def pressed(self):
+		return [ key for write in self.keyboard.writes
+			for key, value in write if value == 1 ]
+
+
+class TestTextInjector(object):
+	
+	def test_layout(self):
+		""" Tests that characters are converted to correct keys """
+		layout = KeyboardLayout.default()
+		assert layout.lookup("a") == (Keys.KEY_A, ())
+		assert layout.lookup("A") == (Keys.KEY_A, (Keys.KEY_LEFTSHIFT,))
+		assert layout.lookup("1") == (Keys.KEY_1, ())
+		assert layout.lookup("!") == (Keys.KEY_1, (Keys.KEY_LEFTSHIFT,))
+		assert layout.lookup(" ") == (Keys.KEY_SPACE, ())
+		assert layout.lookup("\n") == (Keys.KEY_ENTER, ())
+		assert layout.lookup("?") == (Keys.KEY_SLASH, (Keys.KEY_LEFTSHIFT,))
+		assert layout.lookup("ž") is None
+	
+	
+	def test_keysyms(self):
+		""" Tests converting keysyms to characters """
+		assert keysym_to_unicode(0x61) == "a"
+		assert keysym_to_unicode(0xe9) == "é"
+		assert keysym_to_unicode(0x100017e) == "ž"
+		assert keysym_to_unicode(0xff0d) == "\n"
+	
+	
+	def test_batch(self):
+		"""
+		Tests that short text is typed with single write and that
+		modifiers are pressed around key that needs them
+		"""
+		m = FakeMapper()
+		m.text_injector.type("Hi!")
+		m.run()
+		assert len(m.keyboard.writes) == 1
+		S = Keys.KEY_LEFTSHIFT
+		assert m.keyboard.writes[0] == [
+			(S, 1), (Keys.KEY_H, 1), (Keys.KEY_H, 0), (S, 0),
+			(Keys.KEY_I, 1), (Keys.KEY_I, 0),
+			(S, 1), (Keys.KEY_1, 1), (Keys.KEY_1, 0), (S, 0),
+		]
+	
+	
+	def test_long_text(self):
+		""" Tests that long text is split into multiple writes """
+		m = FakeMapper()
+		text = "abcdefghij" * 10
+		m.text_injector.type(text)
+		m.run()
+		assert len(m.keyboard.writes) > 1
+		assert len(m.pressed()) == len(text)
+	
+	
+	def test_delay(self):
+		""" Tests that only one character is typed per write with delay set """
+		m = FakeMapper()
+		m.text_injector.type("abc", 0.01)
+		m.run()
+		assert m.pressed() == [ Keys.KEY_A, Keys.KEY_B, Keys.KEY_C ]
+		assert len(m.keyboard.writes) == 3
+	
+	
+	def test_unknown(self):
+		""" Tests that characters not in layout are skipped without X """
+		m = FakeMapper()
+		m.text_injector.type("ažb")
+		m.run()
+		assert m.pressed() == [ Keys.KEY_A, Keys.KEY_B ]
+	
+	
+	def test_callback(self):
+		""" Tests that callback is called only after whole text is typed """
+		m = FakeMapper()
+		done = []
+		m.text_injector.type("abcdefghij" * 5, 0, lambda mapper: done.append(len(m.pressed())))
+		m.text_injector.type("", 0, lambda mapper: done.append(len(m.pressed())))
+		m.run()
+		assert done == [ 50, 50 ]
+	
+	
+	def test_macro(self):
+		"""
+		Tests that action following type() in macro is executed only
+		after whole text is typed
+		"""
+		parser = ActionParser()
+		for string in ("type('long chat message, longer than one batch'); button(KEY_ENTER)",
+						"type('abc', 0.05); button(KEY_ENTER)"):
+			mapper = Mapper(Profile(parser), Scheduler(), keyboard=False,
+				mouse=False, gamepad=False, poller=None)
+			mapper.keyboard = FakeKeyboard()
+			order = []
+			action = parser.restart(string).parse()
+			action.button_press(mapper)
+			deadline = time.time() + 5
+			while Keys.KEY_ENTER not in order and time.time() < deadline:
+				mapper.scheduler.run()
+				order += [ key for write in mapper.keyboard.writes
+					for key, value in write if value == 1 ]
+				order += mapper.keypress_list
+				mapper.keyboard.writes, mapper.keypress_list[:] = [], []
+			text = action.actions[0].letters
+			assert len(order) == len(text) + 1
+			assert order[-1] == Keys.KEY_ENTER
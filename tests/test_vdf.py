@@ -1,4 +1,4 @@
-from scc.lib.vdf import parse_vdf
+from scc.lib.vdf import parse_vdf, parse_vdf_file, _parse_vdf_python, _get_lib
 from scc.foreign.vdf import VDFProfile
 from cStringIO import StringIO
 import os, pytest
@@ -83,3 +83,27 @@ class TestVDF(object):
 			filename = os.path.join(path, f)
 			print "Testing import of '%s'" % (filename,)
 			VDFProfile().load(filename)
+	
+	
+	def test_native_parser(self):
+		"""
+		Tests if native parser generates same data as python one for every
+		*.vdf file in tests/vdfs and fails in same way on invalid input.
+		"""
+		if not _get_lib():
+			pytest.skip("libvdf is not compiled")
+		path = "tests/vdfs"
+		for f in os.listdir(path):
+			filename = os.path.join(path, f)
+			assert parse_vdf_file(filename) == _parse_vdf_python(open(filename, "r"))
+		for data in ( '"a" "b" "A" { "c" "d" } "a" "e"', "a 'b' c#comment\nd e",
+				'"a" "b" } }', '{ "a" "b" }', '"a" { "b" "c"', '"a" "b' ):
+			try:
+				expected = _parse_vdf_python(StringIO(data))
+			except ValueError, e:
+				expected = e.message
+			try:
+				parsed = parse_vdf(StringIO(data))
+			except ValueError, e:
+				parsed = e.message
+			assert parsed == expected